@@ -0,0 +1,107 @@
+#pragma once
+
+#include "defines.h"
+
+#include <stddef.h>
+
+/*
+Intrusive doubly linked list. A list_node is embedded in the owning struct, so
+linking and unlinking never allocate, and an item can be removed in O(1) given
+only a pointer to it. The list itself is a sentinel node, which makes an empty
+list point at itself and removes every head/tail special case.
+*/
+
+typedef struct list_node {
+    struct list_node* prev;
+    struct list_node* next;
+} list_node;
+
+typedef struct list {
+    // Sentinel. head.next is the first node, head.prev the last.
+    list_node head;
+} list;
+
+// Obtains a pointer to the struct containing the given node.
+#define list_entry(node_ptr, type, member) \
+    ((type*)((u8*)(node_ptr) - offsetof(type, member)))
+
+// Iterates every node in the list front to back. The current node must not be unlinked.
+#define list_for_each(node_ptr, list_ptr) \
+    for (list_node* node_ptr = (list_ptr)->head.next; node_ptr != &(list_ptr)->head; node_ptr = node_ptr->next)
+
+static inline void list_init(list* l) {
+    l->head.prev = &l->head;
+    l->head.next = &l->head;
+}
+
+static inline void list_node_init(list_node* node) {
+    node->prev = node;
+    node->next = node;
+}
+
+static inline b8 list_is_empty(const list* l) {
+    return l->head.next == &l->head;
+}
+
+// Returns TRUE if the node is currently linked into a list.
+static inline b8 list_node_is_linked(const list_node* node) {
+    return node->next != node;
+}
+
+static inline void _list_insert_between(list_node* node, list_node* prev, list_node* next) {
+    node->prev = prev;
+    node->next = next;
+    prev->next = node;
+    next->prev = node;
+}
+
+static inline void list_push_front(list* l, list_node* node) {
+    _list_insert_between(node, &l->head, l->head.next);
+}
+
+static inline void list_push_back(list* l, list_node* node) {
+    _list_insert_between(node, l->head.prev, &l->head);
+}
+
+// Unlinks the node from whichever list it is in. Safe to call on an unlinked, initialized node.
+static inline void list_remove(list_node* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node;
+    node->next = node;
+}
+
+// Returns the first node, or 0 if the list is empty.
+static inline list_node* list_front(const list* l) {
+    return list_is_empty(l) ? 0 : l->head.next;
+}
+
+// Returns the last node, or 0 if the list is empty.
+static inline list_node* list_back(const list* l) {
+    return list_is_empty(l) ? 0 : l->head.prev;
+}
+
+// Unlinks and returns the first node, or 0 if the list is empty.
+static inline list_node* list_pop_front(list* l) {
+    list_node* node = list_front(l);
+    if (node) {
+        list_remove(node);
+    }
+    return node;
+}
+
+// Unlinks and returns the last node, or 0 if the list is empty.
+static inline list_node* list_pop_back(list* l) {
+    list_node* node = list_back(l);
+    if (node) {
+        list_remove(node);
+    }
+    return node;
+}
+
+// Moves an already-linked node to the front of the given list.
+static inline void list_move_to_front(list* l, list_node* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    _list_insert_between(node, &l->head, l->head.next);
+}
@@ -0,0 +1,196 @@
+#include "containers/lru_cache.h"
+
+#include "core/mem.h"
+#include "core/logger.h"
+
+// Keys are frequently already hashes, but may also be small sequential ids, so
+// they are mixed before being reduced to a slot index.
+static u32 slot_for_key(const lru_cache* cache, u64 key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (u32)key & (cache->slot_count - 1);
+}
+
+// Returns the slot holding the key, or -1 if not present.
+static i64 find_slot(const lru_cache* cache, u64 key) {
+    u32 mask = cache->slot_count - 1;
+    u32 slot = slot_for_key(cache, key);
+    while (cache->slots[slot] != 0) {
+        if (cache->entries[cache->slots[slot] - 1].key == key) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+static void insert_slot(lru_cache* cache, u64 key, u32 entry_index) {
+    u32 mask = cache->slot_count - 1;
+    u32 slot = slot_for_key(cache, key);
+    while (cache->slots[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    cache->slots[slot] = entry_index + 1;
+}
+
+// Empties the given slot, shifting any displaced followers back so that probe
+// chains stay unbroken without the need for tombstones.
+static void erase_slot(lru_cache* cache, u32 slot) {
+    u32 mask = cache->slot_count - 1;
+    u32 hole = slot;
+    u32 next = (slot + 1) & mask;
+    while (cache->slots[next] != 0) {
+        u32 home = slot_for_key(cache, cache->entries[cache->slots[next] - 1].key);
+        // Move the follower into the hole if its home is not cyclically within (hole, next].
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            cache->slots[hole] = cache->slots[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    cache->slots[hole] = 0;
+}
+
+// Unlinks the entry in the given slot and returns it to the pool.
+static lru_cache_entry* release_entry(lru_cache* cache, u32 slot) {
+    lru_cache_entry* entry = &cache->entries[cache->slots[slot] - 1];
+    erase_slot(cache, slot);
+    list_remove(&entry->node);
+    list_push_back(&cache->free_entries, &entry->node);
+    cache->used -= entry->size;
+    cache->count--;
+    return entry;
+}
+
+static void evict_entry(lru_cache* cache, lru_cache_entry* entry) {
+    u64 key = entry->key;
+    void* value = entry->value;
+    u64 size = entry->size;
+    release_entry(cache, (u32)find_slot(cache, key));
+    if (cache->on_evict) {
+        cache->on_evict(key, value, size, cache->user_data);
+    }
+}
+
+// Evicts from the cold end until an entry of the given size fits.
+static void evict_for(lru_cache* cache, u64 incoming_size, u32 incoming_count) {
+    while (cache->count > 0 &&
+           (cache->used + incoming_size > cache->budget || cache->count + incoming_count > cache->max_entries)) {
+        evict_entry(cache, list_entry(list_back(&cache->recency), lru_cache_entry, node));
+    }
+}
+
+b8 lru_cache_create(u32 max_entries, u64 budget, PFN_lru_on_evict on_evict, void* user_data, lru_cache* out_cache) {
+    if (max_entries == 0 || !out_cache) {
+        verror("lru_cache_create requires a valid pointer and max_entries > 0.");
+        return FALSE;
+    }
+
+    kzero_memory(out_cache, sizeof(lru_cache));
+    out_cache->budget = budget;
+    out_cache->max_entries = max_entries;
+    out_cache->on_evict = on_evict;
+    out_cache->user_data = user_data;
+
+    // Keep the table at most half full so probe chains stay short.
+    u32 slot_count = 1;
+    while (slot_count < max_entries * 2) {
+        slot_count <<= 1;
+    }
+    out_cache->slot_count = slot_count;
+    out_cache->slots = kallocate(sizeof(u32) * slot_count, MEMORY_TAG_DICT);
+    out_cache->entries = kallocate(sizeof(lru_cache_entry) * max_entries, MEMORY_TAG_DICT);
+
+    list_init(&out_cache->recency);
+    list_init(&out_cache->free_entries);
+    for (u32 i = 0; i < max_entries; ++i) {
+        list_push_back(&out_cache->free_entries, &out_cache->entries[i].node);
+    }
+
+    return TRUE;
+}
+
+void lru_cache_destroy(lru_cache* cache) {
+    if (!cache->entries) {
+        return;
+    }
+    lru_cache_clear(cache);
+    kfree(cache->slots, sizeof(u32) * cache->slot_count, MEMORY_TAG_DICT);
+    kfree(cache->entries, sizeof(lru_cache_entry) * cache->max_entries, MEMORY_TAG_DICT);
+    kzero_memory(cache, sizeof(lru_cache));
+}
+
+void* lru_cache_get(lru_cache* cache, u64 key) {
+    i64 slot = find_slot(cache, key);
+    if (slot < 0) {
+        return 0;
+    }
+    lru_cache_entry* entry = &cache->entries[cache->slots[slot] - 1];
+    list_move_to_front(&cache->recency, &entry->node);
+    return entry->value;
+}
+
+void* lru_cache_peek(lru_cache* cache, u64 key) {
+    i64 slot = find_slot(cache, key);
+    return slot < 0 ? 0 : cache->entries[cache->slots[slot] - 1].value;
+}
+
+b8 lru_cache_put(lru_cache* cache, u64 key, void* value, u64 size) {
+    if (size > cache->budget) {
+        vwarn("lru_cache_put: entry of %llu bytes exceeds the cache budget of %llu bytes.", size, cache->budget);
+        return FALSE;
+    }
+
+    i64 slot = find_slot(cache, key);
+    if (slot >= 0) {
+        lru_cache_entry* existing = &cache->entries[cache->slots[slot] - 1];
+        if (existing->value == value) {
+            // Re-putting the stored value only updates its size and recency; the value is
+            // still in use, so it must not be passed to on_evict.
+            cache->used = cache->used - existing->size + size;
+            existing->size = size;
+            list_move_to_front(&cache->recency, &existing->node);
+            // The entry is now the most recent and fits the budget on its own, so only others go.
+            evict_for(cache, 0, 0);
+            return TRUE;
+        }
+        // Replacing an existing key releases the old value first.
+        evict_entry(cache, existing);
+    }
+
+    evict_for(cache, size, 1);
+
+    lru_cache_entry* entry = list_entry(list_pop_front(&cache->free_entries), lru_cache_entry, node);
+    entry->key = key;
+    entry->value = value;
+    entry->size = size;
+    list_push_front(&cache->recency, &entry->node);
+    insert_slot(cache, key, (u32)(entry - cache->entries));
+    cache->used += size;
+    cache->count++;
+    return TRUE;
+}
+
+b8 lru_cache_remove(lru_cache* cache, u64 key, void** out_value) {
+    i64 slot = find_slot(cache, key);
+    if (slot < 0) {
+        return FALSE;
+    }
+    lru_cache_entry* entry = release_entry(cache, (u32)slot);
+    if (out_value) {
+        *out_value = entry->value;
+    }
+    return TRUE;
+}
+
+void lru_cache_set_budget(lru_cache* cache, u64 budget) {
+    cache->budget = budget;
+    evict_for(cache, 0, 0);
+}
+
+void lru_cache_clear(lru_cache* cache) {
+    while (!list_is_empty(&cache->recency)) {
+        evict_entry(cache, list_entry(list_back(&cache->recency), lru_cache_entry, node));
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "defines.h"
+#include "containers/list.h"
+
+/*
+Least-recently-used cache keyed by u64 (typically a hash of a resource name or
+its creation parameters). Lookups go through an open-addressed table, recency is
+tracked with an intrusive list, and the cache keeps the summed size of its
+entries under a byte budget by evicting from the cold end.
+
+The cache does not own the values it stores. Whenever an entry leaves the cache
+through eviction, replacement or destruction, on_evict is invoked so the owner
+can release the resource (e.g. free a texture tagged MEMORY_TAG_TEXTURE).
+*/
+
+// Invoked when an entry is evicted from the cache.
+typedef void (*PFN_lru_on_evict)(u64 key, void* value, u64 size, void* user_data);
+
+typedef struct lru_cache_entry {
+    list_node node;
+    u64 key;
+    void* value;
+    u64 size;
+} lru_cache_entry;
+
+typedef struct lru_cache {
+    // The maximum summed size of all entries, in bytes.
+    u64 budget;
+    // The current summed size of all entries, in bytes.
+    u64 used;
+    // The maximum number of entries.
+    u32 max_entries;
+    // The number of entries currently held.
+    u32 count;
+    // The number of slots in the lookup table. Always a power of two.
+    u32 slot_count;
+
+    // Entry pool of max_entries elements.
+    lru_cache_entry* entries;
+    // Lookup table. Each slot holds an index + 1 into entries, or 0 if empty.
+    u32* slots;
+
+    // Most recently used at the front, least recently used at the back.
+    list recency;
+    // Unused entries from the pool.
+    list free_entries;
+
+    PFN_lru_on_evict on_evict;
+    void* user_data;
+} lru_cache;
+
+/**
+ * Creates a new LRU cache.
+ * @param max_entries The maximum number of entries held at once. Must be > 0.
+ * @param budget The maximum summed size of the entries, in bytes.
+ * @param on_evict Callback invoked for every entry that leaves the cache. Can be 0/NULL.
+ * @param user_data Passed through to on_evict. Can be 0/NULL.
+ * @param out_cache A pointer to hold the created cache.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+VAPI b8 lru_cache_create(u32 max_entries, u64 budget, PFN_lru_on_evict on_evict, void* user_data, lru_cache* out_cache);
+
+/**
+ * Destroys the cache, invoking on_evict for each remaining entry.
+ * @param cache A pointer to the cache to destroy.
+ */
+VAPI void lru_cache_destroy(lru_cache* cache);
+
+/**
+ * Looks up the value for the given key and marks it as most recently used.
+ * @param cache A pointer to the cache.
+ * @param key The key to look up.
+ * @returns The stored value, or 0 if not present.
+ */
+VAPI void* lru_cache_get(lru_cache* cache, u64 key);
+
+/**
+ * Looks up the value for the given key without affecting recency.
+ * @param cache A pointer to the cache.
+ * @param key The key to look up.
+ * @returns The stored value, or 0 if not present.
+ */
+VAPI void* lru_cache_peek(lru_cache* cache, u64 key);
+
+/**
+ * Inserts or replaces the value for the given key, marking it as most recently used.
+ * Least recently used entries are evicted until the new entry fits in both the entry
+ * and byte budgets. A replaced value is passed to on_evict, unless it is the same pointer
+ * as value: putting the stored value again only updates its size and recency.
+ * @param cache A pointer to the cache.
+ * @param key The key to store the value under.
+ * @param value The value to be stored.
+ * @param size The size of the value in bytes, counted against the budget.
+ * @returns TRUE on success; FALSE if the value alone exceeds the budget.
+ */
+VAPI b8 lru_cache_put(lru_cache* cache, u64 key, void* value, u64 size);
+
+/**
+ * Removes the entry for the given key without invoking on_evict.
+ * @param cache A pointer to the cache.
+ * @param key The key to remove.
+ * @param out_value A pointer to hold the removed value. Can be 0/NULL.
+ * @returns TRUE if an entry was removed; otherwise FALSE.
+ */
+VAPI b8 lru_cache_remove(lru_cache* cache, u64 key, void** out_value);
+
+/**
+ * Changes the byte budget, evicting least recently used entries until it is met.
+ * @param cache A pointer to the cache.
+ * @param budget The new budget in bytes.
+ */
+VAPI void lru_cache_set_budget(lru_cache* cache, u64 budget);
+
+/**
+ * Evicts every entry, invoking on_evict for each.
+ * @param cache A pointer to the cache.
+ */
+VAPI void lru_cache_clear(lru_cache* cache);
@@ -0,0 +1,218 @@
+#include "containers/sort.h"
+
+#include "core/mem.h"
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX_BUCKETS - 1)
+
+static void insertion_sort_u32(u32* keys, u32* values, u64 count) {
+    for (u64 i = 1; i < count; ++i) {
+        u32 key = keys[i];
+        u32 value = values ? values[i] : 0;
+        u64 j = i;
+        while (j > 0 && keys[j - 1] > key) {
+            keys[j] = keys[j - 1];
+            if (values) {
+                values[j] = values[j - 1];
+            }
+            --j;
+        }
+        keys[j] = key;
+        if (values) {
+            values[j] = value;
+        }
+    }
+}
+
+static void insertion_sort_u64(u64* keys, u32* values, u64 count) {
+    for (u64 i = 1; i < count; ++i) {
+        u64 key = keys[i];
+        u32 value = values ? values[i] : 0;
+        u64 j = i;
+        while (j > 0 && keys[j - 1] > key) {
+            keys[j] = keys[j - 1];
+            if (values) {
+                values[j] = values[j - 1];
+            }
+            --j;
+        }
+        keys[j] = key;
+        if (values) {
+            values[j] = value;
+        }
+    }
+}
+
+// Converts the counts of a histogram into exclusive prefix offsets. Returns TRUE if
+// more than one bucket is occupied, i.e. the pass would actually move something.
+static b8 histogram_to_offsets(u64* histogram, u64 count) {
+    u64 sum = 0;
+    for (u32 i = 0; i < RADIX_BUCKETS; ++i) {
+        u64 c = histogram[i];
+        if (c == count) {
+            // Every key shares this digit, the pass is a no-op.
+            return FALSE;
+        }
+        histogram[i] = sum;
+        sum += c;
+    }
+    return TRUE;
+}
+
+void radix_sort_u32(u32* keys, u32* values, u64 count, u32* scratch_keys, u32* scratch_values) {
+    if (count < 2) {
+        return;
+    }
+    if (count <= SORT_SMALL_THRESHOLD) {
+        insertion_sort_u32(keys, values, count);
+        return;
+    }
+
+    const u32 pass_count = sizeof(u32);
+    u64 histograms[sizeof(u32)][RADIX_BUCKETS];
+    kzero_memory(histograms, sizeof(histograms));
+
+    // Build every histogram in a single read over the keys.
+    for (u64 i = 0; i < count; ++i) {
+        u32 key = keys[i];
+        histograms[0][key & RADIX_MASK]++;
+        histograms[1][(key >> 8) & RADIX_MASK]++;
+        histograms[2][(key >> 16) & RADIX_MASK]++;
+        histograms[3][key >> 24]++;
+    }
+
+    b8 owns_keys = scratch_keys == 0;
+    b8 owns_values = values && scratch_values == 0;
+    if (owns_keys) {
+        scratch_keys = kallocate(sizeof(u32) * count, MEMORY_TAG_ARRAY);
+    }
+    if (owns_values) {
+        scratch_values = kallocate(sizeof(u32) * count, MEMORY_TAG_ARRAY);
+    }
+
+    u32* src_keys = keys;
+    u32* dst_keys = scratch_keys;
+    u32* src_values = values;
+    u32* dst_values = scratch_values;
+    for (u32 pass = 0; pass < pass_count; ++pass) {
+        u64* offsets = histograms[pass];
+        if (!histogram_to_offsets(offsets, count)) {
+            continue;
+        }
+
+        u32 shift = pass * RADIX_BITS;
+        if (values) {
+            for (u64 i = 0; i < count; ++i) {
+                u64 dst = offsets[(src_keys[i] >> shift) & RADIX_MASK]++;
+                dst_keys[dst] = src_keys[i];
+                dst_values[dst] = src_values[i];
+            }
+        } else {
+            for (u64 i = 0; i < count; ++i) {
+                dst_keys[offsets[(src_keys[i] >> shift) & RADIX_MASK]++] = src_keys[i];
+            }
+        }
+
+        // Swap the buffers for the next pass.
+        u32* temp = src_keys;
+        src_keys = dst_keys;
+        dst_keys = temp;
+        temp = src_values;
+        src_values = dst_values;
+        dst_values = temp;
+    }
+
+    // An odd number of executed passes leaves the result in scratch.
+    if (src_keys != keys) {
+        kcopy_memory(keys, src_keys, sizeof(u32) * count);
+        if (values) {
+            kcopy_memory(values, src_values, sizeof(u32) * count);
+        }
+    }
+
+    if (owns_keys) {
+        kfree(scratch_keys, sizeof(u32) * count, MEMORY_TAG_ARRAY);
+    }
+    if (owns_values) {
+        kfree(scratch_values, sizeof(u32) * count, MEMORY_TAG_ARRAY);
+    }
+}
+
+void radix_sort_u64(u64* keys, u32* values, u64 count, u64* scratch_keys, u32* scratch_values) {
+    if (count < 2) {
+        return;
+    }
+    if (count <= SORT_SMALL_THRESHOLD) {
+        insertion_sort_u64(keys, values, count);
+        return;
+    }
+
+    const u32 pass_count = sizeof(u64);
+    u64 histograms[sizeof(u64)][RADIX_BUCKETS];
+    kzero_memory(histograms, sizeof(histograms));
+
+    // Build every histogram in a single read over the keys.
+    for (u64 i = 0; i < count; ++i) {
+        u64 key = keys[i];
+        for (u32 pass = 0; pass < pass_count; ++pass) {
+            histograms[pass][(key >> (pass * RADIX_BITS)) & RADIX_MASK]++;
+        }
+    }
+
+    b8 owns_keys = scratch_keys == 0;
+    b8 owns_values = values && scratch_values == 0;
+    if (owns_keys) {
+        scratch_keys = kallocate(sizeof(u64) * count, MEMORY_TAG_ARRAY);
+    }
+    if (owns_values) {
+        scratch_values = kallocate(sizeof(u32) * count, MEMORY_TAG_ARRAY);
+    }
+
+    u64* src_keys = keys;
+    u64* dst_keys = scratch_keys;
+    u32* src_values = values;
+    u32* dst_values = scratch_values;
+    for (u32 pass = 0; pass < pass_count; ++pass) {
+        u64* offsets = histograms[pass];
+        if (!histogram_to_offsets(offsets, count)) {
+            continue;
+        }
+
+        u32 shift = pass * RADIX_BITS;
+        if (values) {
+            for (u64 i = 0; i < count; ++i) {
+                u64 dst = offsets[(src_keys[i] >> shift) & RADIX_MASK]++;
+                dst_keys[dst] = src_keys[i];
+                dst_values[dst] = src_values[i];
+            }
+        } else {
+            for (u64 i = 0; i < count; ++i) {
+                dst_keys[offsets[(src_keys[i] >> shift) & RADIX_MASK]++] = src_keys[i];
+            }
+        }
+
+        // Swap the buffers for the next pass.
+        u64* temp_keys = src_keys;
+        src_keys = dst_keys;
+        dst_keys = temp_keys;
+        u32* temp_values = src_values;
+        src_values = dst_values;
+        dst_values = temp_values;
+    }
+
+    // An odd number of executed passes leaves the result in scratch.
+    if (src_keys != keys) {
+        kcopy_memory(keys, src_keys, sizeof(u64) * count);
+        if (values) {
+            kcopy_memory(values, src_values, sizeof(u32) * count);
+        }
+    }
+
+    if (owns_keys) {
+        kfree(scratch_keys, sizeof(u64) * count, MEMORY_TAG_ARRAY);
+    }
+    if (owns_values) {
+        kfree(scratch_values, sizeof(u32) * count, MEMORY_TAG_ARRAY);
+    }
+}
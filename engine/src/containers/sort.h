@@ -0,0 +1,39 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+LSD radix sort for integer keys with an optional u32 payload (typically an index
+into the array of items the keys were built from). Keys are sorted ascending, and
+the sort is stable, so items with equal keys keep their submission order.
+
+Each pass moves 8 bits at a time through a scratch buffer. All histograms are built
+in a single read over the keys, and passes where every key shares the same digit are
+skipped entirely, which is common for render keys whose upper bits are mostly constant.
+Inputs at or below SORT_SMALL_THRESHOLD fall back to an insertion sort.
+*/
+
+// At or below this element count, an insertion sort is used instead of radix passes.
+#define SORT_SMALL_THRESHOLD 64
+
+/**
+ * Sorts the provided u32 keys in ascending order, permuting values alongside them.
+ * @param keys The keys to be sorted in place. Required.
+ * @param values An optional payload array of count elements. Can be 0/NULL.
+ * @param count The number of keys (and values).
+ * @param scratch_keys A scratch buffer of count keys. If 0/NULL, one is allocated for the call.
+ * @param scratch_values A scratch buffer of count values. Only used if values are provided.
+ * If 0/NULL, one is allocated for the call.
+ */
+VAPI void radix_sort_u32(u32* keys, u32* values, u64 count, u32* scratch_keys, u32* scratch_values);
+
+/**
+ * Sorts the provided u64 keys in ascending order, permuting values alongside them.
+ * @param keys The keys to be sorted in place. Required.
+ * @param values An optional payload array of count elements. Can be 0/NULL.
+ * @param count The number of keys (and values).
+ * @param scratch_keys A scratch buffer of count keys. If 0/NULL, one is allocated for the call.
+ * @param scratch_values A scratch buffer of count values. Only used if values are provided.
+ * If 0/NULL, one is allocated for the call.
+ */
+VAPI void radix_sort_u64(u64* keys, u32* values, u64 count, u64* scratch_keys, u32* scratch_values);
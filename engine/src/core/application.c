@@ -6,8 +6,13 @@
 #include "platform/platform.h"
 #include "core/mem.h"
 #include "core/event.h"
+#include "core/event_record.h"
 #include "core/input.h"
+#include "core/input_action.h"
+#include "core/latency.h"
 #include "core/clock.h"
+#include "core/frame_limiter.h"
+#include "core/str.h"
 
 #include "renderer/renderer_frontend.h"
 
@@ -19,7 +24,15 @@ typedef struct application_state {
     i16 width;
     i16 height;
     clock clock;
-    f64 last_time;
+    // Clock time at the start of the previous frame, in nanoseconds.
+    u64 last_time;
+    // Fixed-timestep mode; step is 0 if disabled.
+    u64 fixed_step_ns;
+    u64 fixed_accumulator_ns;
+    u32 max_fixed_steps;
+    // Steps dropped since fixed updates started falling behind, reported once they catch up.
+    u64 fixed_dropped_steps;
+    b8 fixed_behind;
 } application_state;
 
 static b8 initialized = FALSE;
@@ -38,9 +51,23 @@ b8 application_create(game* game_inst) {
 
     app_state.game_inst = game_inst;
 
+    if (game_inst->app_config.fixed_update_rate && !game_inst->fixed_update) {
+        verror("app_config.fixed_update_rate is set, but game->fixed_update is not assigned.");
+        return FALSE;
+    }
+    app_state.fixed_step_ns = game_inst->app_config.fixed_update_rate ? 1000000000ULL / game_inst->app_config.fixed_update_rate : 0;
+    app_state.fixed_accumulator_ns = 0;
+    app_state.max_fixed_steps = game_inst->app_config.max_fixed_steps_per_frame ? game_inst->app_config.max_fixed_steps_per_frame : APPLICATION_DEFAULT_MAX_FIXED_STEPS;
+
     // Initialize subsystems.
     initialize_logging();
+    clock_initialize();
+    string_initialize();
+    string_intern_initialize();
     input_initialize();
+    input_action_system_initialize();
+    latency_initialize();
+    frame_limiter_initialize(game_inst->app_config.target_frame_rate);
 
 
     app_state.is_running = TRUE;
@@ -56,6 +83,14 @@ b8 application_create(game* game_inst) {
     event_register(EVENT_CODE_KEY_RELEASED, 0, application_on_key);
     event_register(EVENT_CODE_RESIZED, 0, application_on_resized);
 
+    if (game_inst->app_config.event_replay_path) {
+        if (!event_replay_start(game_inst->app_config.event_replay_path)) {
+            return FALSE;
+        }
+    } else if (game_inst->app_config.event_record_path) {
+        event_recording_start(game_inst->app_config.event_record_path);
+    }
+
     if (!platform_startup(
             &app_state.platform,
             game_inst->app_config.name,
@@ -85,27 +120,82 @@ b8 application_create(game* game_inst) {
     return TRUE;
 }
 
+// Runs as many fixed updates as the time accumulated since the last frame covers, up to
+// the per-frame limit, and computes how far the frame lies between steps.
+static b8 application_run_fixed_updates(u64 delta_ns, f32* out_alpha) {
+    app_state.fixed_accumulator_ns += delta_ns;
+    f32 step_seconds = (f32)clock_ns_to_seconds(app_state.fixed_step_ns);
+
+    u32 steps = 0;
+    while (app_state.fixed_accumulator_ns >= app_state.fixed_step_ns && steps < app_state.max_fixed_steps) {
+        if (!app_state.game_inst->fixed_update(app_state.game_inst, step_seconds)) {
+            return FALSE;
+        }
+        app_state.fixed_accumulator_ns -= app_state.fixed_step_ns;
+        steps++;
+    }
+
+    if (app_state.fixed_accumulator_ns >= app_state.fixed_step_ns) {
+        // Too far behind to catch up: the simulation slows down rather than stalling the frame.
+        // Logged when it starts and when it ends, not on every frame in between.
+        if (!app_state.fixed_behind) {
+            vwarn("Fixed update falling behind; dropping steps beyond %u per frame.", app_state.max_fixed_steps);
+            app_state.fixed_behind = TRUE;
+        }
+        app_state.fixed_dropped_steps += app_state.fixed_accumulator_ns / app_state.fixed_step_ns;
+        app_state.fixed_accumulator_ns %= app_state.fixed_step_ns;
+    } else if (app_state.fixed_behind) {
+        vinfo("Fixed update caught up; dropped %llu steps (%.1fms) while behind.",
+              app_state.fixed_dropped_steps, clock_ns_to_ms(app_state.fixed_dropped_steps * app_state.fixed_step_ns));
+        app_state.fixed_behind = FALSE;
+        app_state.fixed_dropped_steps = 0;
+    }
+
+    *out_alpha = (f32)((f64)app_state.fixed_accumulator_ns / (f64)app_state.fixed_step_ns);
+    return TRUE;
+}
+
 b8 application_run() {
     clock_start(&app_state.clock);
     clock_update(&app_state.clock);
-    app_state.last_time = app_state.clock.elapsed;
-    f64 running_time = 0;
-    u8 frame_count = 0;
-    f64 target_frame_seconds = 1.0f / 60;
+    app_state.last_time = app_state.clock.elapsed_ns;
 
     vinfo(get_memory_usage_str());
 
     while (app_state.is_running) {
-        if (!platform_pump_messages(&app_state.platform)) {
+        if (event_replay_is_active()) {
+            // Recorded events stand in for the platform's.
+            if (!event_replay_pump()) {
+                vinfo("Event replay finished, shutting down.");
+                app_state.is_running = FALSE;
+            }
+        } else if (!platform_pump_messages(&app_state.platform)) {
             app_state.is_running = FALSE;
         }
 
+        // Dispatch events posted since the last frame, including any posted by the platform.
+        event_dispatch_posted();
+
         if (!app_state.is_suspended) {
+            // Resolve input actions from everything pumped this frame, before the game reads them.
+            input_action_system_update();
+
+            // Inputs pumped so far are attributed to this frame, whose id is carried to the renderer.
+            u64 frame_id = event_frame_number();
+            latency_frame_begin(frame_id);
+
             // Update clock and get delta time.
             clock_update(&app_state.clock);
-            f64 current_time = app_state.clock.elapsed;
-            f64 delta = (current_time - app_state.last_time);
-            f64 frame_start_time = platform_get_absolute_time();
+            u64 current_time = app_state.clock.elapsed_ns;
+            u64 delta_ns = current_time - app_state.last_time;
+            f64 delta = clock_ns_to_seconds(delta_ns);
+
+            f32 alpha = 1.0f;
+            if (app_state.fixed_step_ns && !application_run_fixed_updates(delta_ns, &alpha)) {
+                vfatal("Game fixed update failed, shutting down.");
+                app_state.is_running = FALSE;
+                break;
+            }
 
             if (!app_state.game_inst->update(app_state.game_inst, (f32)delta)) {
                 vfatal("Game update failed, shutting down.");
@@ -114,7 +204,7 @@ b8 application_run() {
             }
 
             // Call the game's render routine.
-            if (!app_state.game_inst->render(app_state.game_inst, (f32)delta)) {
+            if (!app_state.game_inst->render(app_state.game_inst, (f32)delta, alpha)) {
                 vfatal("Game render failed, shutting down.");
                 app_state.is_running = FALSE;
                 break;
@@ -123,25 +213,11 @@ b8 application_run() {
             // TODO: refactor packet creation
             render_packet packet;
             packet.delta_time = delta;
+            packet.frame_id = frame_id;
             renderer_draw_frame(&packet);
 
-            // Figure out how long the frame took and, if below
-            f64 frame_end_time = platform_get_absolute_time();
-            f64 frame_elapsed_time = frame_end_time - frame_start_time;
-            running_time += frame_elapsed_time;
-            f64 remaining_seconds = target_frame_seconds - frame_elapsed_time;
-
-            if (remaining_seconds > 0) {
-                u64 remaining_ms = (remaining_seconds * 1000);
-
-                // If there is time left, give it back to the OS.
-                b8 limit_frames = FALSE;
-                if (remaining_ms > 0 && limit_frames) {
-                    platform_sleep(remaining_ms - 1);
-                }
-
-                frame_count++;
-            }
+            // Hold the frame to the target frame rate, if one is set.
+            frame_limiter_wait();
 
             // NOTE: Input update/state copying should always be handled
             // after any input should be recorded; I.E. before this line.
@@ -151,22 +227,40 @@ b8 application_run() {
 
             // Update last time
             app_state.last_time = current_time;
+        } else {
+            // Time spent suspended is not simulated: the frame after resuming sees a normal
+            // delta, rather than one spanning the whole suspension.
+            clock_update(&app_state.clock);
+            app_state.last_time = app_state.clock.elapsed_ns;
         }
+
+        // Ends the event frame even while suspended, so that events pumped while minimized
+        // (such as the restoring resize) are recorded and replays keep advancing.
+        event_frame_end();
     }
 
     app_state.is_running = FALSE;
 
     // Shutdown event system.
+    event_recording_stop();
+    event_replay_stop();
     event_unregister(EVENT_CODE_APPLICATION_QUIT, 0, application_on_event);
     event_unregister(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
     event_unregister(EVENT_CODE_KEY_RELEASED, 0, application_on_key);
-    event_shutdown();
+    input_action_system_shutdown();
+    latency_shutdown();
+    frame_limiter_shutdown();
     input_shutdown();
 
     renderer_shutdown();
 
     platform_shutdown(&app_state.platform);
 
+    // After the platform, which may still post events (e.g. resizes) while shutting down.
+    event_shutdown();
+
+    string_intern_shutdown();
+
     return TRUE;
 }
 
@@ -4,6 +4,8 @@
 
 struct game;
 
+#define APPLICATION_DEFAULT_MAX_FIXED_STEPS 5
+
 // Application configuration.
 typedef struct application_config {
     // Window starting position x axis, if applicable.
@@ -20,6 +22,28 @@ typedef struct application_config {
 
     // The application name used in windowing, if applicable.
     char* name;
+
+    // Frames are held to this rate, if set; otherwise the application runs as fast as it can.
+    // See core/frame_limiter.h.
+    u32 target_frame_rate;
+
+    // If set, game->fixed_update is called at this rate (in Hz) with a constant delta,
+    // as many times per frame as the elapsed time requires, and render is given how far
+    // the frame lies between the last two steps.
+    u32 fixed_update_rate;
+
+    // The most fixed updates run in one frame. Time beyond that is dropped, so that a
+    // slow step cannot snowball into ever more steps per frame. 0 uses
+    // APPLICATION_DEFAULT_MAX_FIXED_STEPS.
+    u32 max_fixed_steps_per_frame;
+
+    // If set, events from the platform layer are recorded to this file. See core/event_record.h.
+    const char* event_record_path;
+
+    // If set, events are replayed from this recording instead of coming from the platform
+    // layer, and the application shuts down when the replay ends. Takes precedence over
+    // event_record_path.
+    const char* event_replay_path;
 } application_config;
 
 
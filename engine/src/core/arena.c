@@ -0,0 +1,99 @@
+#include "core/arena.h"
+
+static arena_block* arena_block_create(u64 size, memory_tag tag, arena_block* next) {
+    arena_block* block = kallocate(sizeof(arena_block) + size, tag);
+    block->next = next;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+static void arena_free_blocks(arena* a) {
+    arena_block* block = a->current;
+    while (block) {
+        arena_block* next = block->next;
+        kfree(block, sizeof(arena_block) + block->size, a->tag);
+        block = next;
+    }
+    a->current = 0;
+}
+
+void arena_create(u64 block_size, memory_tag tag, arena* out_arena) {
+    kzero_memory(out_arena, sizeof(arena));
+    out_arena->block_size = block_size;
+    out_arena->tag = tag;
+}
+
+void arena_destroy(arena* a) {
+    arena_free_blocks(a);
+    a->allocated = 0;
+}
+
+void* arena_allocate(arena* a, u64 size, u64 alignment) {
+    if (alignment == 0) {
+        alignment = 1;
+    }
+
+    arena_block* block = a->current;
+    if (block) {
+        u8* base = (u8*)(block + 1);
+        u64 address = (u64)(base + block->used);
+        u64 aligned = (address + (alignment - 1)) & ~(alignment - 1);
+        u64 offset = aligned - (u64)base;
+        if (offset + size <= block->size) {
+            block->used = offset + size;
+            a->allocated += size;
+            return (void*)aligned;
+        }
+    }
+
+    // Doesn't fit, chain on a new block large enough for the request.
+    u64 needed = size + alignment;
+    u64 block_size = needed > a->block_size ? needed : a->block_size;
+    block = arena_block_create(block_size, a->tag, a->current);
+    a->current = block;
+
+    u8* base = (u8*)(block + 1);
+    u64 aligned = ((u64)base + (alignment - 1)) & ~(alignment - 1);
+    block->used = (aligned - (u64)base) + size;
+    a->allocated += size;
+    return (void*)aligned;
+}
+
+b8 arena_try_resize(arena* a, void* block, u64 old_size, u64 new_size) {
+    arena_block* current = a->current;
+    if (!current) {
+        return FALSE;
+    }
+
+    u8* base = (u8*)(current + 1);
+    u64 offset = (u64)((u8*)block - base);
+    // Only the most recent allocation in the current block can be resized.
+    if ((u8*)block < base || offset + old_size != current->used) {
+        return FALSE;
+    }
+    if (offset + new_size > current->size) {
+        return FALSE;
+    }
+
+    current->used = offset + new_size;
+    a->allocated = a->allocated - old_size + new_size;
+    return TRUE;
+}
+
+void arena_reset(arena* a) {
+    arena_block* block = a->current;
+    if (block && block->next) {
+        // More than one block was needed. Coalesce into a single block of the combined
+        // size so the same workload fits without chaining next time.
+        u64 total = 0;
+        for (arena_block* b = block; b; b = b->next) {
+            total += b->size;
+        }
+        arena_free_blocks(a);
+        a->current = arena_block_create(total, a->tag, 0);
+    } else if (block) {
+        block->used = 0;
+    }
+    a->allocated = 0;
+}
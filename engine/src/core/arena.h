@@ -0,0 +1,73 @@
+#pragma once
+
+#include "defines.h"
+#include "core/mem.h"
+
+/*
+Growable linear (bump) allocator. Memory is handed out from large blocks obtained
+through kallocate under the arena's tag, and is only ever released all at once via
+arena_reset or arena_destroy. There is no fixed cap: when the current block is
+exhausted a new one is chained on, sized to fit the request if it is larger than
+the default block size.
+
+Intended for transient data with a well-defined lifetime, such as per-frame scratch.
+*/
+
+typedef struct arena_block {
+    struct arena_block* next;
+    u64 size;
+    u64 used;
+    // Data follows the header.
+} arena_block;
+
+typedef struct arena {
+    // The block currently being allocated from. Older blocks are chained through next.
+    arena_block* current;
+    // The default size of newly-created blocks.
+    u64 block_size;
+    // The tag used for all block allocations.
+    memory_tag tag;
+    // The total bytes handed out since the last reset.
+    u64 allocated;
+} arena;
+
+/**
+ * Creates a new arena. No memory is allocated until the first allocation.
+ * @param block_size The default size of each block, in bytes.
+ * @param tag The memory tag to allocate blocks under.
+ * @param out_arena A pointer to hold the created arena.
+ */
+VAPI void arena_create(u64 block_size, memory_tag tag, arena* out_arena);
+
+/**
+ * Releases all blocks held by the arena.
+ * @param a A pointer to the arena to destroy.
+ */
+VAPI void arena_destroy(arena* a);
+
+/**
+ * Allocates memory from the arena. The memory is not zeroed.
+ * @param a A pointer to the arena.
+ * @param size The size of the allocation, in bytes.
+ * @param alignment The required alignment. Must be a power of two.
+ * @returns A pointer to the allocated memory.
+ */
+VAPI void* arena_allocate(arena* a, u64 size, u64 alignment);
+
+/**
+ * Attempts to resize the most recent allocation in place.
+ * @param a A pointer to the arena.
+ * @param block The most recent allocation made from the arena.
+ * @param old_size The current size of the allocation.
+ * @param new_size The requested size of the allocation.
+ * @returns TRUE if the allocation was resized; otherwise FALSE.
+ */
+VAPI b8 arena_try_resize(arena* a, void* block, u64 old_size, u64 new_size);
+
+/**
+ * Invalidates every allocation made from the arena. A single block is kept: if more than
+ * one was in use, all are freed and replaced by one block of their combined size, so a
+ * steady-state workload stops allocating after warm-up.
+ * @param a A pointer to the arena.
+ */
+VAPI void arena_reset(arena* a);
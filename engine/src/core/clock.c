@@ -1,18 +1,135 @@
 #include "clock.h"
 
+#include "core/logger.h"
 #include "platform/platform.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define CLOCK_HAS_TSC 1
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#define CLOCK_HAS_TSC 1
+#else
+#define CLOCK_HAS_TSC 0
+#endif
+
+// How long the tick rate is measured for at startup.
+#define CLOCK_CALIBRATION_MS 10
+
+// Nanoseconds per tick as fixed point with ns_per_tick_shift fractional bits, or 0 if
+// ticks are nanoseconds. Kept below 2^32 so conversion cannot overflow.
+static u64 ns_per_tick_fixed = 0;
+static u32 ns_per_tick_shift = 0;
+
+#if CLOCK_HAS_TSC
+// An invariant TSC runs at a constant rate across P-states and sleep states.
+static b8 clock_has_invariant_tsc() {
+#if defined(_MSC_VER)
+    i32 regs[4];
+    __cpuid(regs, 0x80000000);
+    if ((u32)regs[0] < 0x80000007) {
+        return FALSE;
+    }
+    __cpuid(regs, 0x80000007);
+    return (regs[3] >> 8) & 1;
+#else
+    u32 eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0x80000000, 0) < 0x80000007 || !__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+        return FALSE;
+    }
+    return (edx >> 8) & 1;
+#endif
+}
+
+// Samples the counter on both sides of a clock read, returning the midpoint. The
+// tightest of several attempts is kept, as a read can be preempted.
+static u64 clock_sample(u64* out_ns) {
+    u64 best_window = ~0ULL;
+    u64 best_ticks = 0;
+    for (u32 i = 0; i < 8; ++i) {
+        u64 ns;
+        u64 before = __rdtsc();
+        ns = platform_get_absolute_time_ns();
+        u64 after = __rdtsc();
+        if (after - before < best_window) {
+            best_window = after - before;
+            best_ticks = before + best_window / 2;
+            *out_ns = ns;
+        }
+    }
+    return best_ticks;
+}
+#endif
+
+void clock_initialize() {
+    ns_per_tick_fixed = 0;
+#if CLOCK_HAS_TSC
+    if (!clock_has_invariant_tsc()) {
+        vinfo("Clock: no invariant TSC; ticks use the monotonic clock.");
+        return;
+    }
+    u64 start_ns, end_ns;
+    u64 start_ticks = clock_sample(&start_ns);
+    platform_sleep(CLOCK_CALIBRATION_MS);
+    u64 end_ticks = clock_sample(&end_ns);
+
+    u64 ticks = end_ticks - start_ticks;
+    u64 ns = end_ns - start_ns;
+    // Anything under 100MHz is not a plausible TSC; don't trust it.
+    if (end_ticks <= start_ticks || ns == 0 || ticks < ns / 10) {
+        vwarn("Clock: TSC calibration failed; ticks use the monotonic clock.");
+        return;
+    }
+    f64 ns_per_tick = (f64)ns / (f64)ticks;
+    ns_per_tick_shift = 32;
+    while (ns_per_tick_shift > 0 && ns_per_tick * (f64)(1ULL << ns_per_tick_shift) >= 4294967296.0) {
+        ns_per_tick_shift--;
+    }
+    ns_per_tick_fixed = (u64)(ns_per_tick * (f64)(1ULL << ns_per_tick_shift) + 0.5);
+    vinfo("Clock: using invariant TSC at %.3f MHz.", (f64)ticks / (f64)ns * 1000.0);
+#endif
+}
+
+u64 clock_now_ns() {
+    return platform_get_absolute_time_ns();
+}
+
+u64 clock_ticks() {
+#if CLOCK_HAS_TSC
+    if (ns_per_tick_fixed) {
+        return __rdtsc();
+    }
+#endif
+    return platform_get_absolute_time_ns();
+}
+
+u64 clock_ticks_to_ns(u64 ticks) {
+    if (!ns_per_tick_fixed) {
+        return ticks;
+    }
+    // Split so the fixed point multiply cannot overflow.
+    u64 fraction_mask = (1ULL << ns_per_tick_shift) - 1;
+    return (ticks >> ns_per_tick_shift) * ns_per_tick_fixed + (((ticks & fraction_mask) * ns_per_tick_fixed) >> ns_per_tick_shift);
+}
+
+b8 clock_ticks_are_tsc() {
+    return ns_per_tick_fixed != 0;
+}
+
 void clock_update(clock* clock) {
     if (clock->start_time != 0) {
-        clock->elapsed = platform_get_absolute_time() - clock->start_time;
+        clock->elapsed_ns = platform_get_absolute_time_ns() - clock->start_time;
+        clock->elapsed = clock_ns_to_seconds(clock->elapsed_ns);
     }
 }
 
 void clock_start(clock* clock) {
-    clock->start_time = platform_get_absolute_time();
+    clock->start_time = platform_get_absolute_time_ns();
+    clock->elapsed_ns = 0;
     clock->elapsed = 0;
 }
 
 void clock_stop(clock* clock) {
     clock->start_time = 0;
-}
\ No newline at end of file
+}
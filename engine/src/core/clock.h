@@ -1,11 +1,53 @@
 #pragma once
 #include "defines.h"
 
+/*
+Time is kept as unsigned 64-bit nanoseconds from a monotonic source, which keeps
+full precision however long the process runs (f64 seconds lose a bit of precision
+every time uptime doubles).
+
+For instrumentation there is also a tick counter. Where the CPU has an invariant
+timestamp counter it is read directly (a few nanoseconds, no system call) and
+converted using a rate calibrated against the monotonic clock at startup; elsewhere
+ticks are simply nanoseconds. Ticks are only comparable within a process, so store
+them as differences and convert with clock_ticks_to_ns.
+*/
+
 typedef struct clock {
-    f64 start_time;
+    // Nanoseconds at start, or 0 if the clock is not started.
+    u64 start_time;
+    u64 elapsed_ns;
+    // elapsed_ns in seconds.
     f64 elapsed;
 } clock;
 
+// Detects and calibrates the tick counter. Called once at startup; takes about 10ms.
+void clock_initialize();
+
+// The current monotonic time in nanoseconds.
+VAPI u64 clock_now_ns();
+
+// Reads the tick counter. Far cheaper than clock_now_ns if clock_ticks_are_tsc().
+VAPI u64 clock_ticks();
+
+// Converts a number of ticks (normally a difference of clock_ticks() readings) to nanoseconds.
+VAPI u64 clock_ticks_to_ns(u64 ticks);
+
+// Returns TRUE if ticks come from a calibrated CPU timestamp counter.
+VAPI b8 clock_ticks_are_tsc();
+
+static inline f64 clock_ns_to_seconds(u64 ns) {
+    return (f64)ns * 0.000000001;
+}
+
+static inline f64 clock_ns_to_ms(u64 ns) {
+    return (f64)ns * 0.000001;
+}
+
+static inline u64 clock_seconds_to_ns(f64 seconds) {
+    return seconds > 0 ? (u64)(seconds * 1000000000.0 + 0.5) : 0;
+}
+
 // Updates the provided clock. Should be called just before checking elapsed time.
 // Has no effect on non-started clocks.
 void clock_update(clock* clock);
@@ -0,0 +1,36 @@
+#include "core/cpu.h"
+
+static b8 detected = FALSE;
+static u32 features = 0;
+
+static void cpu_detect() {
+    features = 0;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        features |= CPU_FEATURE_SSE2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        features |= CPU_FEATURE_SSE42;
+    }
+    // NOTE: This also verifies that the OS saves the YMM registers.
+    if (__builtin_cpu_supports("avx2")) {
+        features |= CPU_FEATURE_AVX2;
+    }
+#elif defined(_M_X64)
+    // SSE2 is part of the x64 baseline.
+    features |= CPU_FEATURE_SSE2;
+#endif
+    detected = TRUE;
+}
+
+u32 cpu_get_features() {
+    if (!detected) {
+        cpu_detect();
+    }
+    return features;
+}
+
+b8 cpu_has_feature(cpu_feature feature) {
+    return (cpu_get_features() & feature) != 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "defines.h"
+
+// Instruction set extensions that code paths may be specialized for.
+typedef enum cpu_feature {
+    CPU_FEATURE_SSE2 = 1 << 0,
+    CPU_FEATURE_SSE42 = 1 << 1,
+    CPU_FEATURE_AVX2 = 1 << 2,
+} cpu_feature;
+
+/**
+ * Obtains the set of features supported by both the CPU and the OS. Detected once on
+ * first use and cached.
+ * @returns A combination of cpu_feature flags.
+ */
+VAPI u32 cpu_get_features();
+
+// Returns TRUE if the given feature is supported.
+VAPI b8 cpu_has_feature(cpu_feature feature);
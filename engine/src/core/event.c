@@ -1,24 +1,153 @@
 #include "core/event.h"
 
 #include "core/mem.h"
+#include "core/arena.h"
+#include "core/clock.h"
+#include "core/logger.h"
+#include "core/str.h"
 #include "containers/darray.h"
 
+#include <stdatomic.h>
+
 typedef struct registered_event {
     void* listener;
+    // 0 once unregistered; the record is removed at the next compaction.
     PFN_on_event callback;
+    // Index of the listener slot backing this registration's handle.
+    u32 slot;
+    u8 priority;
 } registered_event;
 
 typedef struct event_code_entry {
+    // Ordered by priority, then registration order, except for records appended while the
+    // code was firing, which are put in place by the next compaction.
     registered_event* events;
+    // Sequence number + 1 of this code's queued event, if coalescing. 0 if none is queued.
+    u64 pending;
+    event_coalesce_policy coalesce;
+    // Number of fires of this code in progress. The events array is only reordered at 0.
+    u16 firing_depth;
+    // Set when records need to be removed or re-sorted once the code stops firing.
+    b8 needs_compaction;
+    u16 code;
 } event_code_entry;
 
-// This should be more than enough codes...
-#define MAX_MESSAGE_CODES 16384
+// Backs a listener handle. Handles combine the slot index with its generation, which is
+// bumped on unregister so stale handles are rejected.
+typedef struct event_listener_slot {
+    u32 generation;
+    // The registration's index in its code's events array while in use; otherwise the
+    // next free slot.
+    u32 position;
+    u16 code;
+    b8 in_use;
+} event_listener_slot;
+
+#define INVALID_LISTENER_SLOT 0xFFFFFFFF
+
+// Codes map to entries through pages of slots, allocated the first time a code in the
+// page is used. Together the pages cover the full u16 range.
+#define EVENT_CODE_PAGE_SIZE 256
+#define EVENT_CODE_PAGE_COUNT (65536 / EVENT_CODE_PAGE_SIZE)
+
+// Holds the entry index + 1 for each code in the page, or 0 if the code has no entry.
+typedef struct event_code_page {
+    u32 slots[EVENT_CODE_PAGE_SIZE];
+} event_code_page;
+
+// Initial capacity of the deferred event queue. Must be a power of 2.
+#define EVENT_QUEUE_INITIAL_CAPACITY 256
+
+typedef struct posted_event {
+    u16 code;
+    void* sender;
+    event_context context;
+} posted_event;
+
+// Ring buffer of events waiting for event_dispatch_posted. Grows when full.
+typedef struct event_queue {
+    posted_event* events;
+    // Always a power of 2.
+    u32 capacity;
+    u32 head;
+    u32 count;
+    // Sequence number of the event at head. Incremented on every dequeue.
+    u64 head_sequence;
+    u32 coalesced_since_drain;
+    event_queue_stats stats;
+} event_queue;
+
+// Capacity of the queue for events posted from other threads. Must be a power of 2.
+#define EVENT_THREAD_QUEUE_CAPACITY 4096
+
+typedef struct thread_event_slot {
+    // Equals the slot's position when free and position + 1 once an event is published.
+    _Atomic u64 sequence;
+    posted_event event;
+} thread_event_slot;
+
+// Bounded lock-free queue for events posted from threads other than the one that
+// initialized the event system (D. Vyukov's bounded MPMC queue, consumed by one
+// thread). Producers claim a position with a CAS on tail and publish through the
+// slot's sequence, so no thread ever waits on another.
+typedef struct thread_event_queue {
+    thread_event_slot* slots;
+    // Only touched by the consuming (main) thread.
+    u64 head;
+    // Kept on its own cache line, as every producer writes it.
+    _Alignas(64) _Atomic u64 tail;
+    _Atomic u64 dropped;
+} thread_event_queue;
+
+// Per-code profiling data, kept in a darray parallel to the entries.
+typedef struct code_profile_record {
+    event_code_profile profile;
+    u32 fires_this_frame;
+    u32 handlers_this_frame;
+} code_profile_record;
+
+// Initial capacity of the handler profile table. Must be a power of 2.
+#define HANDLER_PROFILE_INITIAL_CAPACITY 64
+
+typedef struct event_profile_state {
+    b8 enabled;
+    u32 dump_interval_frames;
+    u64 frame;
+    code_profile_record* codes;
+    // Open-addressed table keyed by callback address; empty where callback is 0.
+    event_handler_profile* handlers;
+    u32 handler_capacity;
+    u32 handler_count;
+} event_profile_state;
+
+// Default block size of the payload arenas.
+#define EVENT_PAYLOAD_ARENA_BLOCK_SIZE (64 * 1024)
 
 // State structure.
 typedef struct event_system_state {
-    // Lookup table for event codes.
-    event_code_entry registered[MAX_MESSAGE_CODES];
+    // Pages mapping codes to entries; 0 where no code in the page has been used.
+    event_code_page* code_pages[EVENT_CODE_PAGE_COUNT];
+    // darray of entries for every code in use, packed together. Entries are never removed
+    // while the system is running, so indices into this are stable.
+    event_code_entry* entries;
+    // darray of slots backing listener handles, with a free list through unused ones.
+    event_listener_slot* listener_slots;
+    u32 free_listener_slot;
+    event_queue queue;
+    thread_event_queue thread_queue;
+    event_profile_state profile;
+    // Frames completed since initialization.
+    u64 frame;
+    // Number of handler invocations in progress, across all codes.
+    u32 invoke_depth;
+    // TRUE from the end of a frame until the next drain starts; the window in which the
+    // platform layer delivers external input.
+    b8 input_phase;
+    PFN_event_capture capture_hook;
+    // Payloads are allocated from the arena indexed by the frame number's lowest bit. An
+    // event posted late in a frame is dispatched in the next one, so each arena is only
+    // reset at the end of the frame after the one it was allocated in.
+    arena payload_arenas[2];
 } event_system_state;
 
 /**
@@ -26,6 +155,35 @@ typedef struct event_system_state {
  */
 static b8 is_initialized = FALSE;
 static event_system_state state;
+// TRUE only on the thread that initialized the event system, which owns dispatch.
+static _Thread_local b8 is_event_thread = FALSE;
+
+#define INVALID_EVENT_ENTRY 0xFFFFFFFF
+
+// Returns the index of the code's entry, or INVALID_EVENT_ENTRY if it has none.
+static inline u32 event_entry_find(u16 code) {
+    event_code_page* page = state.code_pages[code / EVENT_CODE_PAGE_SIZE];
+    if (!page) {
+        return INVALID_EVENT_ENTRY;
+    }
+    return page->slots[code % EVENT_CODE_PAGE_SIZE] - 1;
+}
+
+// Returns the index of the code's entry, creating it if needed.
+static u32 event_entry_acquire(u16 code) {
+    event_code_page** page = &state.code_pages[code / EVENT_CODE_PAGE_SIZE];
+    if (!*page) {
+        *page = kallocate(sizeof(event_code_page), MEMORY_TAG_DICT);
+    }
+    u32* slot = &(*page)->slots[code % EVENT_CODE_PAGE_SIZE];
+    if (!*slot) {
+        event_code_entry entry = {};
+        entry.code = code;
+        darray_push(state.entries, entry);
+        *slot = (u32)darray_length(state.entries);
+    }
+    return *slot - 1;
+}
 
 b8 event_initialize() {
     if (is_initialized == TRUE) {
@@ -34,6 +192,32 @@ b8 event_initialize() {
     is_initialized = FALSE;
     kzero_memory(&state, sizeof(state));
 
+    state.queue.capacity = EVENT_QUEUE_INITIAL_CAPACITY;
+    state.queue.events = kallocate(sizeof(posted_event) * state.queue.capacity, MEMORY_TAG_RING_QUEUE);
+
+    state.thread_queue.slots = kallocate(sizeof(thread_event_slot) * EVENT_THREAD_QUEUE_CAPACITY, MEMORY_TAG_RING_QUEUE);
+    for (u64 i = 0; i < EVENT_THREAD_QUEUE_CAPACITY; ++i) {
+        atomic_init(&state.thread_queue.slots[i].sequence, i);
+    }
+    atomic_init(&state.thread_queue.tail, 0);
+    atomic_init(&state.thread_queue.dropped, 0);
+    is_event_thread = TRUE;
+    state.input_phase = TRUE;
+    arena_create(EVENT_PAYLOAD_ARENA_BLOCK_SIZE, MEMORY_TAG_RING_QUEUE, &state.payload_arenas[0]);
+    arena_create(EVENT_PAYLOAD_ARENA_BLOCK_SIZE, MEMORY_TAG_RING_QUEUE, &state.payload_arenas[1]);
+
+    state.entries = darray_create(event_code_entry);
+    state.listener_slots = darray_create(event_listener_slot);
+    state.free_listener_slot = INVALID_LISTENER_SLOT;
+
+    // High-frequency platform events only need their latest value each frame.
+    u32 resized = event_entry_acquire(EVENT_CODE_RESIZED);
+    state.entries[resized].coalesce = EVENT_COALESCE_KEEP_LAST;
+    u32 mouse_moved = event_entry_acquire(EVENT_CODE_MOUSE_MOVED);
+    state.entries[mouse_moved].coalesce = EVENT_COALESCE_KEEP_LAST;
+    u32 raw_motion = event_entry_acquire(EVENT_CODE_MOUSE_RAW_MOTION);
+    state.entries[raw_motion].coalesce = EVENT_COALESCE_ACCUMULATE_F32;
+
     is_initialized = TRUE;
 
     return TRUE;
@@ -41,37 +225,202 @@ b8 event_initialize() {
 
 void event_shutdown() {
     // Free the events arrays. And objects pointed to should be destroyed on their own.
-    for(u16 i = 0; i < MAX_MESSAGE_CODES; ++i){
-        if(state.registered[i].events != 0) {
-            darray_destroy(state.registered[i].events);
-            state.registered[i].events = 0;
+    if (state.entries) {
+        u64 entry_count = darray_length(state.entries);
+        for (u64 i = 0; i < entry_count; ++i) {
+            if (state.entries[i].events != 0) {
+                darray_destroy(state.entries[i].events);
+            }
+        }
+        darray_destroy(state.entries);
+        state.entries = 0;
+    }
+    if (state.listener_slots) {
+        darray_destroy(state.listener_slots);
+        state.listener_slots = 0;
+    }
+    event_profiling_set_enabled(FALSE, 0);
+    for (u32 i = 0; i < EVENT_CODE_PAGE_COUNT; ++i) {
+        if (state.code_pages[i]) {
+            kfree(state.code_pages[i], sizeof(event_code_page), MEMORY_TAG_DICT);
+            state.code_pages[i] = 0;
         }
     }
+
+    if (state.queue.events) {
+        kfree(state.queue.events, sizeof(posted_event) * state.queue.capacity, MEMORY_TAG_RING_QUEUE);
+        state.queue.events = 0;
+    }
+    if (state.thread_queue.slots) {
+        kfree(state.thread_queue.slots, sizeof(thread_event_slot) * EVENT_THREAD_QUEUE_CAPACITY, MEMORY_TAG_RING_QUEUE);
+        state.thread_queue.slots = 0;
+    }
+    arena_destroy(&state.payload_arenas[0]);
+    arena_destroy(&state.payload_arenas[1]);
+
+    // Posts after shutdown are rejected rather than written to the freed queue.
+    state.queue.capacity = 0;
+    state.queue.count = 0;
+    is_initialized = FALSE;
+}
+
+static inline event_handle make_handle(u32 slot) {
+    return ((u64)state.listener_slots[slot].generation << 32) | slot;
+}
+
+// Returns the slot for a handle, or INVALID_LISTENER_SLOT if the handle is stale or invalid.
+static u32 handle_slot(event_handle handle) {
+    u32 slot = (u32)(handle & 0xFFFFFFFF);
+    u32 generation = (u32)(handle >> 32);
+    if (handle == INVALID_EVENT_HANDLE || slot >= darray_length(state.listener_slots)) {
+        return INVALID_LISTENER_SLOT;
+    }
+    event_listener_slot* s = &state.listener_slots[slot];
+    if (!s->in_use || s->generation != generation) {
+        return INVALID_LISTENER_SLOT;
+    }
+    return slot;
+}
+
+static u32 listener_slot_acquire(u16 code) {
+    u32 slot = state.free_listener_slot;
+    if (slot != INVALID_LISTENER_SLOT) {
+        state.free_listener_slot = state.listener_slots[slot].position;
+    } else {
+        event_listener_slot new_slot = {};
+        darray_push(state.listener_slots, new_slot);
+        slot = (u32)darray_length(state.listener_slots) - 1;
+    }
+    event_listener_slot* s = &state.listener_slots[slot];
+    // Generations start at 1 so that no handle equals INVALID_EVENT_HANDLE.
+    s->generation++;
+    if (s->generation == 0) {
+        s->generation = 1;
+    }
+    s->code = code;
+    s->in_use = TRUE;
+    return slot;
 }
 
-b8 event_register(u16 code, void* listener, PFN_on_event on_event) {
+static void listener_slot_release(u32 slot) {
+    event_listener_slot* s = &state.listener_slots[slot];
+    s->in_use = FALSE;
+    s->generation++;
+    s->position = state.free_listener_slot;
+    state.free_listener_slot = slot;
+}
+
+// Removes unregistered records and restores priority order. Only called while the code
+// is not firing, since it moves records.
+static void event_entry_compact(event_code_entry* entry) {
+    entry->needs_compaction = FALSE;
+    registered_event* events = entry->events;
+    u64 count = darray_length(events);
+
+    // Drop removed records, keeping the order of the rest.
+    u64 kept = 0;
+    for (u64 i = 0; i < count; ++i) {
+        if (events[i].callback) {
+            events[kept++] = events[i];
+        }
+    }
+    darray_length_set(events, kept);
+
+    // Stable insertion sort; records are already sorted apart from the few appended
+    // during a fire.
+    for (u64 i = 1; i < kept; ++i) {
+        registered_event e = events[i];
+        u64 j = i;
+        while (j > 0 && events[j - 1].priority > e.priority) {
+            events[j] = events[j - 1];
+            --j;
+        }
+        events[j] = e;
+    }
+
+    for (u64 i = 0; i < kept; ++i) {
+        state.listener_slots[events[i].slot].position = (u32)i;
+    }
+}
+
+event_handle event_register_priority(u16 code, void* listener, PFN_on_event on_event, event_priority priority) {
     if(is_initialized == FALSE) {
-        return FALSE;
+        return INVALID_EVENT_HANDLE;
     }
 
-    if(state.registered[code].events == 0) {
-        state.registered[code].events = darray_create(registered_event);
+    u32 index = event_entry_acquire(code);
+    event_code_entry* entry = &state.entries[index];
+    if(entry->events == 0) {
+        entry->events = darray_create(registered_event);
     }
 
-    u64 registered_count = darray_length(state.registered[code].events);
+    u64 registered_count = darray_length(entry->events);
     for(u64 i = 0; i < registered_count; ++i) {
-        if(state.registered[code].events[i].listener == listener) {
+        registered_event* e = &entry->events[i];
+        if(e->callback == on_event && e->listener == listener) {
             // TODO: warn
-            return FALSE;
+            return INVALID_EVENT_HANDLE;
         }
     }
 
+    if (entry->firing_depth == 0 && entry->needs_compaction) {
+        event_entry_compact(entry);
+    }
+
     // If at this point, no duplicate was found. Proceed with registration.
     registered_event event;
     event.listener = listener;
     event.callback = on_event;
-    darray_push(state.registered[code].events, event);
+    event.slot = listener_slot_acquire(code);
+    event.priority = (u8)priority;
+
+    if (entry->firing_depth > 0) {
+        // Appending leaves the records being iterated where they are. It also keeps the
+        // new listener out of the fire in progress; compaction sorts it in afterwards.
+        state.listener_slots[event.slot].position = (u32)darray_length(entry->events);
+        darray_push(entry->events, event);
+        entry->needs_compaction = TRUE;
+        return make_handle(event.slot);
+    }
+
+    // Insert after every listener with the same or a higher priority.
+    darray_push(entry->events, event);
+    u64 position = darray_length(entry->events) - 1;
+    while (position > 0 && entry->events[position - 1].priority > event.priority) {
+        entry->events[position] = entry->events[position - 1];
+        state.listener_slots[entry->events[position].slot].position = (u32)position;
+        --position;
+    }
+    entry->events[position] = event;
+    state.listener_slots[event.slot].position = (u32)position;
+
+    return make_handle(event.slot);
+}
+
+event_handle event_register(u16 code, void* listener, PFN_on_event on_event) {
+    return event_register_priority(code, listener, on_event, EVENT_PRIORITY_NORMAL);
+}
+
+// Removes a registration in constant time. The record is cleared in place and removed by
+// the next compaction, which never runs while the code is firing.
+static void event_remove_slot(u32 slot) {
+    event_listener_slot* s = &state.listener_slots[slot];
+    event_code_entry* entry = &state.entries[event_entry_find(s->code)];
+    entry->events[s->position].callback = 0;
+    entry->needs_compaction = TRUE;
+    listener_slot_release(slot);
+}
+
+b8 event_unregister_handle(event_handle handle) {
+    if(is_initialized == FALSE) {
+        return FALSE;
+    }
 
+    u32 slot = handle_slot(handle);
+    if (slot == INVALID_LISTENER_SLOT) {
+        return FALSE;
+    }
+    event_remove_slot(slot);
     return TRUE;
 }
 
@@ -81,18 +430,19 @@ b8 event_unregister(u16 code, void* listener, PFN_on_event on_event) {
     }
 
     // On nothing is registered for the code, boot out.
-    if(state.registered[code].events == 0) {
+    u32 index = event_entry_find(code);
+    if(index == INVALID_EVENT_ENTRY || state.entries[index].events == 0) {
         // TODO: warn
         return FALSE;
     }
 
-    u64 registered_count = darray_length(state.registered[code].events);
+    event_code_entry* entry = &state.entries[index];
+    u64 registered_count = darray_length(entry->events);
     for(u64 i = 0; i < registered_count; ++i) {
-        registered_event e = state.registered[code].events[i];
-        if(e.listener == listener && e.callback == on_event) {
+        registered_event e = entry->events[i];
+        if(e.callback == on_event && e.listener == listener) {
             // Found one, remove it
-            registered_event popped_event;
-            darray_pop_at(state.registered[code].events, i, &popped_event);
+            event_remove_slot(e.slot);
             return TRUE;
         }
     }
@@ -101,25 +451,548 @@ b8 event_unregister(u16 code, void* listener, PFN_on_event on_event) {
     return FALSE;
 }
 
-b8 event_fire(u16 code, void* sender, event_context context) {
-    if(is_initialized == FALSE) {
-        return FALSE;
+// Handler timing brackets every callback, so it uses the tick counter rather than the clock.
+static inline u64 profile_now() {
+    return clock_ticks();
+}
+
+static code_profile_record* profile_code_record(u32 index) {
+    event_profile_state* profile = &state.profile;
+    while (darray_length(profile->codes) <= index) {
+        code_profile_record record = {};
+        record.profile.code = state.entries[darray_length(profile->codes)].code;
+        darray_push(profile->codes, record);
     }
+    return &profile->codes[index];
+}
 
-    // If nothing is registered for the code, boot out.
-    if(state.registered[code].events == 0) {
+static inline u32 handler_profile_hash(PFN_on_event callback, u32 capacity) {
+    u64 key = (u64)callback;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return (u32)key & (capacity - 1);
+}
+
+static event_handler_profile* handler_profile_find_slot(event_handler_profile* table, u32 capacity, PFN_on_event callback) {
+    u32 i = handler_profile_hash(callback, capacity);
+    while (table[i].callback && table[i].callback != callback) {
+        i = (i + 1) & (capacity - 1);
+    }
+    return &table[i];
+}
+
+static void profile_record_handler(PFN_on_event callback, u64 ns) {
+    event_profile_state* profile = &state.profile;
+    // Keep the table at most half full.
+    if ((profile->handler_count + 1) * 2 > profile->handler_capacity) {
+        u32 new_capacity = profile->handler_capacity ? profile->handler_capacity * 2 : HANDLER_PROFILE_INITIAL_CAPACITY;
+        event_handler_profile* new_table = kallocate(sizeof(event_handler_profile) * new_capacity, MEMORY_TAG_DICT);
+        for (u32 i = 0; i < profile->handler_capacity; ++i) {
+            if (profile->handlers[i].callback) {
+                *handler_profile_find_slot(new_table, new_capacity, profile->handlers[i].callback) = profile->handlers[i];
+            }
+        }
+        if (profile->handlers) {
+            kfree(profile->handlers, sizeof(event_handler_profile) * profile->handler_capacity, MEMORY_TAG_DICT);
+        }
+        profile->handlers = new_table;
+        profile->handler_capacity = new_capacity;
+    }
+
+    event_handler_profile* p = handler_profile_find_slot(profile->handlers, profile->handler_capacity, callback);
+    if (!p->callback) {
+        p->callback = callback;
+        profile->handler_count++;
+    }
+    u32 bucket = ns ? 63 - (u32)__builtin_clzll(ns) : 0;
+    if (bucket >= EVENT_PROFILE_HISTOGRAM_BUCKETS) {
+        bucket = EVENT_PROFILE_HISTOGRAM_BUCKETS - 1;
+    }
+    p->calls++;
+    p->total_ns += ns;
+    if (ns > p->max_ns) {
+        p->max_ns = ns;
+    }
+    p->histogram[bucket]++;
+}
+
+// Invokes the listeners of the entry at index in priority order until one handles the
+// event. Handlers may register or unregister listeners (of any code) and fire events.
+// Records are never moved while the code is firing, and the entry itself is accessed
+// through its index because registering a new code can move the entries array.
+static b8 event_entry_invoke(u32 index, u16 code, void* sender, event_context context) {
+    if (state.profile.enabled) {
+        code_profile_record* record = profile_code_record(index);
+        record->fires_this_frame++;
+        record->profile.total_fires++;
+    }
+    if (state.entries[index].events == 0) {
         return FALSE;
     }
 
-    u64 registered_count = darray_length(state.registered[code].events);
+    state.entries[index].firing_depth++;
+    state.invoke_depth++;
+    b8 handled = FALSE;
+    // Listeners registered during the fire are appended past this count.
+    u64 registered_count = darray_length(state.entries[index].events);
     for(u64 i = 0; i < registered_count; ++i) {
-        registered_event e = state.registered[code].events[i];
+        registered_event e = state.entries[index].events[i];
+        if (e.callback == 0) {
+            continue;
+        }
+        if (state.profile.enabled) {
+            u64 start = profile_now();
+            b8 result = e.callback(code, sender, e.listener, context);
+            profile_record_handler(e.callback, clock_ticks_to_ns(profile_now() - start));
+            // The record array may have grown if the handler fired new codes.
+            code_profile_record* record = profile_code_record(index);
+            record->handlers_this_frame++;
+            record->profile.total_handlers++;
+            if (result) {
+                handled = TRUE;
+                break;
+            }
+            continue;
+        }
         if(e.callback(code, sender, e.listener, context)) {
             // Message has been handled, do not send to other listeners.
-            return TRUE;
+            handled = TRUE;
+            break;
         }
     }
 
-    // Not found.
-    return FALSE;
+    state.invoke_depth--;
+    event_code_entry* entry = &state.entries[index];
+    entry->firing_depth--;
+    if (entry->firing_depth == 0 && entry->needs_compaction) {
+        event_entry_compact(entry);
+    }
+    return handled;
+}
+
+// TRUE if an event entering the system now originates outside it, e.g. from the platform
+// layer, rather than being a consequence of another event.
+static inline b8 event_should_capture() {
+    return state.capture_hook && state.input_phase && state.invoke_depth == 0;
+}
+
+b8 event_fire(u16 code, void* sender, event_context context) {
+    if(is_initialized == FALSE) {
+        return FALSE;
+    }
+
+    if (event_should_capture()) {
+        state.capture_hook(state.frame, code, FALSE, context, 0);
+    }
+
+    // If nothing is registered for the code, boot out. When profiling, unheard fires are
+    // still counted, which needs an entry.
+    u32 index = event_entry_find(code);
+    if(index == INVALID_EVENT_ENTRY) {
+        if (!state.profile.enabled) {
+            return FALSE;
+        }
+        index = event_entry_acquire(code);
+    }
+
+    return event_entry_invoke(index, code, sender, context);
+}
+
+// Doubles the queue capacity, unwrapping the contents to the start of the new buffer.
+static void event_queue_grow(event_queue* queue) {
+    u32 new_capacity = queue->capacity * 2;
+    posted_event* new_events = kallocate(sizeof(posted_event) * new_capacity, MEMORY_TAG_RING_QUEUE);
+    u32 first_span = queue->capacity - queue->head;
+    if (first_span > queue->count) {
+        first_span = queue->count;
+    }
+    kcopy_memory(new_events, queue->events + queue->head, sizeof(posted_event) * first_span);
+    kcopy_memory(new_events + first_span, queue->events, sizeof(posted_event) * (queue->count - first_span));
+    kfree(queue->events, sizeof(posted_event) * queue->capacity, MEMORY_TAG_RING_QUEUE);
+    queue->events = new_events;
+    queue->capacity = new_capacity;
+    queue->head = 0;
+}
+
+// Queues an event on the dispatching thread, merging it if the code coalesces.
+static void event_queue_push(u16 code, void* sender, event_context context) {
+    event_queue* queue = &state.queue;
+    queue->stats.total_posted++;
+    // Nothing in here calls out, so the pointer stays valid.
+    u32 index = event_entry_find(code);
+    event_code_entry* entry = index == INVALID_EVENT_ENTRY ? 0 : &state.entries[index];
+
+    // Merge into the queued event for this code, if there is one.
+    if (entry && entry->coalesce != EVENT_COALESCE_NONE && entry->pending) {
+        u32 offset = (u32)(entry->pending - 1 - queue->head_sequence);
+        posted_event* e = &queue->events[(queue->head + offset) & (queue->capacity - 1)];
+        e->sender = sender;
+        switch (entry->coalesce) {
+            case EVENT_COALESCE_ACCUMULATE_I32:
+                for (u32 i = 0; i < 4; ++i) {
+                    e->context.data.i32[i] += context.data.i32[i];
+                }
+                break;
+            case EVENT_COALESCE_ACCUMULATE_F32:
+                for (u32 i = 0; i < 4; ++i) {
+                    e->context.data.f32[i] += context.data.f32[i];
+                }
+                break;
+            default:
+                e->context = context;
+                break;
+        }
+        queue->coalesced_since_drain++;
+        queue->stats.total_coalesced++;
+        return;
+    }
+
+    if (queue->count == queue->capacity) {
+        event_queue_grow(queue);
+    }
+
+    posted_event* e = &queue->events[(queue->head + queue->count) & (queue->capacity - 1)];
+    e->code = code;
+    e->sender = sender;
+    e->context = context;
+    if (entry && entry->coalesce != EVENT_COALESCE_NONE) {
+        entry->pending = queue->head_sequence + queue->count + 1;
+    }
+    queue->count++;
+
+    if (queue->count > queue->stats.peak_depth) {
+        queue->stats.peak_depth = queue->count;
+    }
+}
+
+// Publishes an event from any thread. Returns FALSE if the queue is full.
+static b8 thread_queue_push(thread_event_queue* queue, u16 code, void* sender, event_context context) {
+    u64 position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    thread_event_slot* slot;
+    for (;;) {
+        slot = &queue->slots[position & (EVENT_THREAD_QUEUE_CAPACITY - 1)];
+        u64 sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        i64 difference = (i64)sequence - (i64)position;
+        if (difference == 0) {
+            // The slot is free; try to claim it. On failure, position holds the new tail.
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The consumer hasn't released this slot from the previous lap yet.
+            return FALSE;
+        } else {
+            position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+
+    slot->event.code = code;
+    slot->event.sender = sender;
+    slot->event.context = context;
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+    return TRUE;
+}
+
+// Moves events published by other threads into the dispatch queue, in the order their
+// positions were claimed. Stops at a slot that is claimed but not yet published.
+static void thread_queue_drain(thread_event_queue* queue) {
+    for (;;) {
+        thread_event_slot* slot = &queue->slots[queue->head & (EVENT_THREAD_QUEUE_CAPACITY - 1)];
+        u64 sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (sequence != queue->head + 1) {
+            return;
+        }
+        posted_event e = slot->event;
+        atomic_store_explicit(&slot->sequence, queue->head + EVENT_THREAD_QUEUE_CAPACITY, memory_order_release);
+        queue->head++;
+        event_queue_push(e.code, e.sender, e.context);
+    }
+}
+
+b8 event_post(u16 code, void* sender, event_context context) {
+    if (is_initialized == FALSE) {
+        return FALSE;
+    }
+
+    if (!is_event_thread) {
+        if (!thread_queue_push(&state.thread_queue, code, sender, context)) {
+            atomic_fetch_add_explicit(&state.thread_queue.dropped, 1, memory_order_relaxed);
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    if (event_should_capture()) {
+        state.capture_hook(state.frame, code, TRUE, context, 0);
+    }
+    event_queue_push(code, sender, context);
+    return TRUE;
+}
+
+void* event_payload_allocate(u64 size) {
+    if (is_initialized == FALSE || size == 0) {
+        return 0;
+    }
+    if (!is_event_thread) {
+        verror("event_payload_allocate may only be called on the main thread.");
+        return 0;
+    }
+    return arena_allocate(&state.payload_arenas[state.frame & 1], size, 16);
+}
+
+b8 event_post_payload(u16 code, void* sender, void* payload, u64 size) {
+    if (is_initialized == FALSE) {
+        return FALSE;
+    }
+    if (!is_event_thread) {
+        verror("event_post_payload may only be called on the main thread.");
+        return FALSE;
+    }
+
+    // Accumulating would add the payload pointers together.
+    u32 index = event_entry_find(code);
+    if (index != INVALID_EVENT_ENTRY && (state.entries[index].coalesce == EVENT_COALESCE_ACCUMULATE_I32 ||
+                                         state.entries[index].coalesce == EVENT_COALESCE_ACCUMULATE_F32)) {
+        verror("event_post_payload: code %hu accumulates when coalesced and cannot carry a payload.", code);
+        return FALSE;
+    }
+
+    event_context context;
+    context.data.u64[0] = (u64)payload;
+    context.data.u64[1] = size;
+    if (event_should_capture()) {
+        state.capture_hook(state.frame, code, TRUE, context, payload);
+    }
+    event_queue_push(code, sender, context);
+    return TRUE;
+}
+
+u32 event_dispatch_posted() {
+    if (is_initialized == FALSE) {
+        return 0;
+    }
+
+    event_queue* queue = &state.queue;
+    u64 start_time = clock_now_ns();
+    state.input_phase = FALSE;
+
+    // Events from other threads join the queue behind everything posted on this thread.
+    thread_queue_drain(&state.thread_queue);
+
+    queue->stats.last_drain_coalesced = queue->coalesced_since_drain;
+    queue->coalesced_since_drain = 0;
+
+    // Only dispatch what was queued before the drain started. Handlers may post (and grow
+    // the queue) while dispatching, so each event is copied out before its handlers run.
+    u32 remaining = queue->count;
+    u32 dispatched = remaining;
+    while (remaining > 0) {
+        u16 code = queue->events[queue->head].code;
+        u32 index = event_entry_find(code);
+        if (index == INVALID_EVENT_ENTRY && state.profile.enabled) {
+            index = event_entry_acquire(code);
+        }
+
+        // Dispatch the run of consecutive events with this code against one entry. As in
+        // event_fire, the entry is accessed through its index as handlers may move it.
+        do {
+            posted_event e = queue->events[queue->head];
+            u64 sequence = queue->head_sequence;
+            queue->head = (queue->head + 1) & (queue->capacity - 1);
+            queue->head_sequence++;
+            queue->count--;
+            remaining--;
+            if (index == INVALID_EVENT_ENTRY) {
+                continue;
+            }
+
+            // Once dequeued, further posts of this code must queue a new event.
+            if (state.entries[index].pending == sequence + 1) {
+                state.entries[index].pending = 0;
+            }
+
+            event_entry_invoke(index, code, e.sender, e.context);
+        } while (remaining > 0 && queue->events[queue->head].code == code);
+    }
+
+    f64 elapsed = clock_ns_to_seconds(clock_now_ns() - start_time);
+    queue->stats.last_drain_count = dispatched;
+    queue->stats.last_drain_seconds = elapsed;
+    if (elapsed > queue->stats.max_drain_seconds) {
+        queue->stats.max_drain_seconds = elapsed;
+    }
+    queue->stats.total_dispatched += dispatched;
+    return dispatched;
+}
+
+void event_get_queue_stats(event_queue_stats* out_stats) {
+    *out_stats = state.queue.stats;
+    out_stats->depth = state.queue.count;
+    out_stats->total_dropped = atomic_load_explicit(&state.thread_queue.dropped, memory_order_relaxed);
+}
+
+void event_set_coalesce_policy(u16 code, event_coalesce_policy policy) {
+    if (is_initialized == FALSE) {
+        return;
+    }
+    u32 index = event_entry_acquire(code);
+    event_code_entry* entry = &state.entries[index];
+    entry->coalesce = policy;
+    if (policy == EVENT_COALESCE_NONE) {
+        // Any queued event is still dispatched; later posts just no longer merge into it.
+        entry->pending = 0;
+    }
+}
+
+void event_profiling_set_enabled(b8 enabled, u32 dump_interval_frames) {
+    event_profile_state* profile = &state.profile;
+    if (profile->codes) {
+        darray_destroy(profile->codes);
+    }
+    if (profile->handlers) {
+        kfree(profile->handlers, sizeof(event_handler_profile) * profile->handler_capacity, MEMORY_TAG_DICT);
+    }
+    kzero_memory(profile, sizeof(event_profile_state));
+
+    if (enabled && is_initialized) {
+        profile->enabled = TRUE;
+        profile->dump_interval_frames = dump_interval_frames;
+        profile->codes = darray_create(code_profile_record);
+    }
+}
+
+u32 event_profile_snapshot_codes(event_code_profile* out_profiles, u32 max_profiles) {
+    event_profile_state* profile = &state.profile;
+    u32 count = 0;
+    u64 record_count = profile->codes ? darray_length(profile->codes) : 0;
+    for (u64 i = 0; i < record_count; ++i) {
+        if (profile->codes[i].profile.total_fires == 0) {
+            continue;
+        }
+        if (out_profiles) {
+            if (count >= max_profiles) {
+                break;
+            }
+            out_profiles[count] = profile->codes[i].profile;
+        }
+        count++;
+    }
+    return count;
+}
+
+u32 event_profile_snapshot_handlers(event_handler_profile* out_profiles, u32 max_profiles) {
+    event_profile_state* profile = &state.profile;
+    if (!out_profiles) {
+        return profile->handler_count;
+    }
+    u32 count = 0;
+    for (u32 i = 0; i < profile->handler_capacity && count < max_profiles; ++i) {
+        if (profile->handlers[i].callback) {
+            out_profiles[count++] = profile->handlers[i];
+        }
+    }
+    return count;
+}
+
+// Returns the upper bound, in nanoseconds, of the bucket containing the given percentile.
+static u64 histogram_percentile_ns(const event_handler_profile* p, f64 percentile) {
+    u64 target = (u64)(p->calls * percentile);
+    u64 cumulative = 0;
+    for (u32 i = 0; i < EVENT_PROFILE_HISTOGRAM_BUCKETS; ++i) {
+        cumulative += p->histogram[i];
+        if (cumulative > target) {
+            u64 bound = 2ull << i;
+            return bound < p->max_ns ? bound : p->max_ns;
+        }
+    }
+    return p->max_ns;
+}
+
+void event_profile_dump() {
+    event_profile_state* profile = &state.profile;
+    if (!profile->enabled) {
+        return;
+    }
+
+    char buffer[2048];
+    string_builder builder;
+    string_builder_create_from_buffer(buffer, sizeof(buffer), 0, &builder);
+    string_builder_appendf(&builder, "Event profile at frame %llu:", profile->frame);
+
+    u64 record_count = darray_length(profile->codes);
+    for (u64 i = 0; i < record_count; ++i) {
+        const event_code_profile* c = &profile->codes[i].profile;
+        if (c->total_fires == 0) {
+            continue;
+        }
+        string_builder_appendf(&builder, "\n  code 0x%04x: %u fires last frame (max %u), %u handler calls, %llu fires total",
+                               c->code, c->fires_last_frame, c->max_fires_per_frame, c->handlers_last_frame, c->total_fires);
+    }
+
+    // The slowest handlers by total time.
+    u32 handler_count = profile->handler_count;
+    if (handler_count > 0) {
+        event_handler_profile* sorted = kallocate(sizeof(event_handler_profile) * handler_count, MEMORY_TAG_ARRAY);
+        event_profile_snapshot_handlers(sorted, handler_count);
+        for (u32 i = 1; i < handler_count; ++i) {
+            event_handler_profile p = sorted[i];
+            u32 j = i;
+            while (j > 0 && sorted[j - 1].total_ns < p.total_ns) {
+                sorted[j] = sorted[j - 1];
+                --j;
+            }
+            sorted[j] = p;
+        }
+
+        const u32 max_listed = 10;
+        for (u32 i = 0; i < handler_count && i < max_listed; ++i) {
+            const event_handler_profile* p = &sorted[i];
+            string_builder_appendf(&builder, "\n  handler %p: %llu calls, avg %.2fus, p99 <= %.2fus, max %.2fus",
+                                   (void*)p->callback, p->calls, (f64)p->total_ns / (f64)p->calls / 1000.0,
+                                   (f64)histogram_percentile_ns(p, 0.99) / 1000.0, (f64)p->max_ns / 1000.0);
+        }
+        kfree(sorted, sizeof(event_handler_profile) * handler_count, MEMORY_TAG_ARRAY);
+    }
+
+    vinfo("%s", builder.data);
+    string_builder_destroy(&builder);
+}
+
+void event_frame_end() {
+    state.frame++;
+    state.input_phase = TRUE;
+    // This arena holds payloads from the frame before the one that just ended. Their events
+    // were dispatched by the latest in the frame that just ended.
+    arena_reset(&state.payload_arenas[state.frame & 1]);
+
+    event_profile_state* profile = &state.profile;
+    if (!profile->enabled) {
+        return;
+    }
+
+    u64 record_count = darray_length(profile->codes);
+    for (u64 i = 0; i < record_count; ++i) {
+        code_profile_record* r = &profile->codes[i];
+        r->profile.fires_last_frame = r->fires_this_frame;
+        r->profile.handlers_last_frame = r->handlers_this_frame;
+        if (r->fires_this_frame > r->profile.max_fires_per_frame) {
+            r->profile.max_fires_per_frame = r->fires_this_frame;
+        }
+        r->fires_this_frame = 0;
+        r->handlers_this_frame = 0;
+    }
+
+    profile->frame++;
+    if (profile->dump_interval_frames && profile->frame % profile->dump_interval_frames == 0) {
+        event_profile_dump();
+    }
+}
+
+u64 event_frame_number() {
+    return state.frame;
+}
+
+void event_set_capture_hook(PFN_event_capture hook) {
+    state.capture_hook = hook;
 }
@@ -29,15 +29,43 @@ typedef b8 (*PFN_on_event)(u16 code, void* sender, void* listener_inst, event_co
 b8 event_initialize();
 void event_shutdown();
 
+// Identifies a registration. 0 is never a valid handle.
+typedef u64 event_handle;
+
+#define INVALID_EVENT_HANDLE 0
+
+// Listeners of a code are invoked in priority order, then in registration order.
+typedef enum event_priority {
+    // Runs before everything else. For layers that consume input, such as UI and consoles.
+    EVENT_PRIORITY_HIGH = 0,
+    // The default, for gameplay.
+    EVENT_PRIORITY_NORMAL = 1,
+    // Runs last. For observers that should see whatever was not consumed.
+    EVENT_PRIORITY_LOW = 2
+} event_priority;
+
+/**
+ * Register to listen for when events are sent with the provided code, at normal priority.
+ * Events with duplicate listener/callback combos will not be registered again and will
+ * cause this to return INVALID_EVENT_HANDLE.
+ * @param code The event code to listen for.
+ * @param listener A pointer to a listener instance. Can be 0/NULL.
+ * @param on_event The callback function pointer to be invoked when the event code is fired.
+ * @returns A handle to the registration if successful; otherwise INVALID_EVENT_HANDLE.
+ */
+VAPI event_handle event_register(u16 code, void* listener, PFN_on_event on_event);
+
 /**
- * Register to listen for when events are sent with the provided code. Events with duplicate
- * listener/callback combos will not be registered again and will cause this to return FALSE.
+ * Register to listen for when events are sent with the provided code, at the given
+ * priority. Registering from inside a handler is allowed; the new listener is not
+ * invoked by fires already in progress.
  * @param code The event code to listen for.
  * @param listener A pointer to a listener instance. Can be 0/NULL.
  * @param on_event The callback function pointer to be invoked when the event code is fired.
- * @returns TRUE if the event is successfully registered; otherwise false.
+ * @param priority The band the listener runs in.
+ * @returns A handle to the registration if successful; otherwise INVALID_EVENT_HANDLE.
  */
-VAPI b8 event_register(u16 code, void* listener, PFN_on_event on_event);
+VAPI event_handle event_register_priority(u16 code, void* listener, PFN_on_event on_event, event_priority priority);
 
 /**
  * Unregister from listening for when events are sent with the provided code. If no matching
@@ -49,6 +77,15 @@ VAPI b8 event_register(u16 code, void* listener, PFN_on_event on_event);
  */
 VAPI b8 event_unregister(u16 code, void* listener, PFN_on_event on_event);
 
+/**
+ * Unregisters the registration identified by the handle, in constant time. Unregistering
+ * from inside a handler is allowed; the listener is skipped by fires already in progress
+ * if it has not been invoked yet.
+ * @param handle The handle returned by event_register.
+ * @returns TRUE if unregistered; FALSE if the handle is invalid or already unregistered.
+ */
+VAPI b8 event_unregister_handle(event_handle handle);
+
 /**
  * Fires an event to listeners of the given code. If an event handler returns 
  * TRUE, the event is considered handled and is not passed on to any more listeners.
@@ -59,6 +96,197 @@ VAPI b8 event_unregister(u16 code, void* listener, PFN_on_event on_event);
  */
 VAPI b8 event_fire(u16 code, void* sender, event_context context);
 
+/**
+ * Queues an event to be dispatched later, at the next call to event_dispatch_posted. The
+ * application drains the queue once per frame, right after platform messages are pumped,
+ * so handlers may post events without re-entering the dispatcher. Events posted while the
+ * queue is draining are dispatched on the next drain.
+ *
+ * Unlike the rest of the event API, this may be called from any thread. Posts from other
+ * threads go through a bounded lock-free queue and are dispatched on the main thread at
+ * the next drain, after events posted there, in the order they were posted.
+ * @param code The event code to post.
+ * @param sender A pointer to the sender. Can be 0/NULL. Must remain valid until dispatched.
+ * @param data The event data.
+ * @returns TRUE if the event was queued; FALSE if not initialized or, when posting from
+ * another thread, that queue is full.
+ */
+VAPI b8 event_post(u16 code, void* sender, event_context context);
+
+/**
+ * Dispatches all events queued by event_post before this call, in the order they were
+ * posted. Runs of the same code are dispatched together.
+ * @returns The number of events dispatched.
+ */
+u32 event_dispatch_posted();
+
+/*
+Event payloads. Data that does not fit in an event_context, such as a dropped file path,
+is allocated from the event system's frame arenas and posted by pointer, so neither the
+post nor the dispatch copies it. A payload stays valid until the end of the frame in
+which its event is dispatched; handlers that need it for longer must copy it. Allocations
+are released in bulk at the end of each frame, so there is nothing to free. Frames here are
+event frames (see event_frame_end), which keep advancing while the application is suspended,
+so payloads posted while minimized are recycled as usual.
+
+Payloads are for the main thread only. Events small enough for an event_context should
+keep using event_post, which does not touch the arenas.
+*/
+
+/**
+ * Allocates memory for an event payload from the current frame arena. Only valid on the
+ * thread that initialized the event system.
+ * @param size The size of the payload, in bytes. Must be greater than 0.
+ * @returns A pointer to the uninitialized, 16-byte aligned payload, or 0/NULL on failure.
+ */
+VAPI void* event_payload_allocate(u64 size);
+
+/**
+ * Posts an event carrying a payload. The handlers receive the payload pointer in
+ * data.u64[0] and its size in data.u64[1]; see event_context_payload. Codes posted with
+ * a payload must not use an accumulating coalesce policy.
+ * @param code The event code to post.
+ * @param sender A pointer to the sender. Can be 0/NULL. Must remain valid until dispatched.
+ * @param payload The payload, as returned by event_payload_allocate this frame.
+ * @param size The size of the payload, in bytes.
+ * @returns TRUE if the event was queued; otherwise FALSE.
+ */
+VAPI b8 event_post_payload(u16 code, void* sender, void* payload, u64 size);
+
+// Returns the payload of an event posted with event_post_payload.
+static inline void* event_context_payload(event_context context) {
+    return (void*)context.data.u64[0];
+}
+
+// Returns the size, in bytes, of the payload of an event posted with event_post_payload.
+static inline u64 event_context_payload_size(event_context context) {
+    return context.data.u64[1];
+}
+
+// Statistics for the deferred event queue.
+typedef struct event_queue_stats {
+    // Events currently waiting to be dispatched.
+    u32 depth;
+    // Highest depth seen since initialization.
+    u32 peak_depth;
+    // The number of events dispatched by the most recent drain.
+    u32 last_drain_count;
+    // Time spent in the most recent drain, in seconds.
+    f64 last_drain_seconds;
+    // The longest drain since initialization, in seconds.
+    f64 max_drain_seconds;
+    // The number of posts merged into an already queued event ahead of the most recent drain.
+    u32 last_drain_coalesced;
+    u64 total_posted;
+    u64 total_dispatched;
+    u64 total_coalesced;
+    // Posts from other threads rejected because their queue was full.
+    u64 total_dropped;
+} event_queue_stats;
+
+// How posted events with the same code are merged while they wait in the queue.
+typedef enum event_coalesce_policy {
+    // Every posted event is dispatched. The default.
+    EVENT_COALESCE_NONE = 0,
+    // A post replaces the sender and data of the queued event.
+    EVENT_COALESCE_KEEP_LAST,
+    // A post adds its data, as i32[4], to the queued event.
+    EVENT_COALESCE_ACCUMULATE_I32,
+    // A post adds its data, as f32[4], to the queued event.
+    EVENT_COALESCE_ACCUMULATE_F32
+} event_coalesce_policy;
+
+/**
+ * Sets how posted events with the given code are coalesced. With any policy other than
+ * EVENT_COALESCE_NONE, at most one event per code waits in the queue: later posts are
+ * merged into it and it is dispatched at the position of the first post. Events sent
+ * with event_fire are never coalesced. EVENT_CODE_RESIZED and EVENT_CODE_MOUSE_MOVED
+ * default to EVENT_COALESCE_KEEP_LAST, and EVENT_CODE_MOUSE_RAW_MOTION to
+ * EVENT_COALESCE_ACCUMULATE_F32.
+ * @param code The event code.
+ * @param policy The coalescing policy.
+ */
+VAPI void event_set_coalesce_policy(u16 code, event_coalesce_policy policy);
+
+// Obtains a copy of the deferred event queue statistics.
+VAPI void event_get_queue_stats(event_queue_stats* out_stats);
+
+/*
+Event profiling. When enabled, every fire and posted dispatch records, per code, the
+number of fires and handler invocations per frame, and, per handler callback (keyed by
+function address), the number of calls and a histogram of inclusive call times. Times
+include any events fired from inside the handler. Disabled by default; when disabled the
+cost is one branch per fire.
+*/
+
+// Histogram bucket i counts calls that took [2^i, 2^(i+1)) nanoseconds; bucket 0 also
+// counts anything under 1ns.
+#define EVENT_PROFILE_HISTOGRAM_BUCKETS 32
+
+typedef struct event_code_profile {
+    u16 code;
+    u32 fires_last_frame;
+    u32 handlers_last_frame;
+    u32 max_fires_per_frame;
+    u64 total_fires;
+    u64 total_handlers;
+} event_code_profile;
+
+typedef struct event_handler_profile {
+    PFN_on_event callback;
+    u64 calls;
+    u64 total_ns;
+    u64 max_ns;
+    u32 histogram[EVENT_PROFILE_HISTOGRAM_BUCKETS];
+} event_handler_profile;
+
+/**
+ * Enables or disables event profiling. Enabling clears previously collected data.
+ * @param enabled TRUE to enable profiling.
+ * @param dump_interval_frames If non-zero, event_profile_dump is called every this many frames.
+ */
+VAPI void event_profiling_set_enabled(b8 enabled, u32 dump_interval_frames);
+
+/**
+ * Copies the per-code profile of every code that has been fired since profiling was enabled.
+ * @param out_profiles The array to write to. If 0/NULL, only the count is returned.
+ * @param max_profiles The capacity of out_profiles.
+ * @returns The number of profiles written, or available if out_profiles is 0/NULL.
+ */
+VAPI u32 event_profile_snapshot_codes(event_code_profile* out_profiles, u32 max_profiles);
+
+/**
+ * Copies the profile of every handler callback invoked since profiling was enabled.
+ * @param out_profiles The array to write to. If 0/NULL, only the count is returned.
+ * @param max_profiles The capacity of out_profiles.
+ * @returns The number of profiles written, or available if out_profiles is 0/NULL.
+ */
+VAPI u32 event_profile_snapshot_handlers(event_handler_profile* out_profiles, u32 max_profiles);
+
+// Logs the busiest codes and the slowest handlers collected so far.
+VAPI void event_profile_dump();
+
+// Marks the end of a frame for the event system, recycling the older payload arena. Called
+// by the application once per main loop iteration, including while suspended.
+void event_frame_end();
+
+// Returns the number of frames completed since the event system was initialized.
+VAPI u64 event_frame_number();
+
+/**
+ * Receives events as they enter the system from outside: those fired or posted on the main
+ * thread, not from inside a handler, between the end of a frame and the next drain of
+ * posted events. In practice, these are the events produced by platform_pump_messages.
+ * Consequences of those events, events from other threads and events produced while
+ * updating are not captured, as they are regenerated when the captured ones are replayed.
+ * For events posted with a payload, payload points to it (its size is in the context);
+ * otherwise it is 0/NULL.
+ */
+typedef void (*PFN_event_capture)(u64 frame, u16 code, b8 posted, event_context context, const void* payload);
+
+// Sets the capture hook, used by the event recorder. Pass 0 to remove it.
+void event_set_capture_hook(PFN_event_capture hook);
+
 // System internal event codes. Application should use codes beyond 255.
 typedef enum system_event_code {
     // Shuts the application down on the next frame.
@@ -67,24 +295,28 @@ typedef enum system_event_code {
     // Keyboard key pressed.
     /* Context usage:
      * u16 key_code = data.data.u16[0];
+     * u32 timestamp = data.data.u32[1];
      */
     EVENT_CODE_KEY_PRESSED = 0x02,
 
     // Keyboard key released.
     /* Context usage:
      * u16 key_code = data.data.u16[0];
+     * u32 timestamp = data.data.u32[1];
      */
     EVENT_CODE_KEY_RELEASED = 0x03,
 
     // Mouse button pressed.
     /* Context usage:
      * u16 button = data.data.u16[0];
+     * u32 timestamp = data.data.u32[1];
      */
     EVENT_CODE_BUTTON_PRESSED = 0x04,
 
     // Mouse button released.
     /* Context usage:
      * u16 button = data.data.u16[0];
+     * u32 timestamp = data.data.u32[1];
      */
     EVENT_CODE_BUTTON_RELEASED = 0x05,
 
@@ -108,5 +340,33 @@ typedef enum system_event_code {
      */
     EVENT_CODE_RESIZED = 0x08,
 
+    // Raw, unaccelerated mouse motion, where the platform reports it.
+    /* Context usage:
+     * f32 dx = data.data.f32[0];
+     * f32 dy = data.data.f32[1];
+     */
+    EVENT_CODE_MOUSE_RAW_MOTION = 0x09,
+
+    // Gamepad button pressed.
+    /* Context usage:
+     * u16 button = data.data.u16[0];
+     * u16 gamepad_index = data.data.u16[1];
+     */
+    EVENT_CODE_GAMEPAD_BUTTON_PRESSED = 0x0A,
+
+    // Gamepad button released.
+    /* Context usage:
+     * u16 button = data.data.u16[0];
+     * u16 gamepad_index = data.data.u16[1];
+     */
+    EVENT_CODE_GAMEPAD_BUTTON_RELEASED = 0x0B,
+
+    // Gamepad connected or disconnected.
+    /* Context usage:
+     * u16 gamepad_index = data.data.u16[0];
+     * u8 connected = data.data.u8[2];
+     */
+    EVENT_CODE_GAMEPAD_CONNECTION = 0x0C,
+
     MAX_EVENT_CODE = 0xFF
 } system_event_code;
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "core/event_channel.h"
+
+#include "core/mem.h"
+
+// Initial capacity of a channel's listener list.
+#define EVENT_CHANNEL_INITIAL_CAPACITY 4
+
+b8 event_channel_register(event_channel* channel, void* listener, PFN_event_channel_callback callback) {
+    for (u32 i = 0; i < channel->count; ++i) {
+        if (channel->listeners[i].listener == listener && channel->listeners[i].callback == callback) {
+            return FALSE;
+        }
+    }
+
+    if (channel->count == channel->capacity) {
+        u32 new_capacity = channel->capacity ? channel->capacity * 2 : EVENT_CHANNEL_INITIAL_CAPACITY;
+        event_channel_listener* listeners = kallocate(sizeof(event_channel_listener) * new_capacity, MEMORY_TAG_ARRAY);
+        if (channel->listeners) {
+            kcopy_memory(listeners, channel->listeners, sizeof(event_channel_listener) * channel->count);
+            kfree(channel->listeners, sizeof(event_channel_listener) * channel->capacity, MEMORY_TAG_ARRAY);
+        }
+        channel->listeners = listeners;
+        channel->capacity = new_capacity;
+    }
+
+    event_channel_listener* l = &channel->listeners[channel->count++];
+    l->listener = listener;
+    l->callback = callback;
+    return TRUE;
+}
+
+b8 event_channel_unregister(event_channel* channel, void* listener, PFN_event_channel_callback callback) {
+    for (u32 i = 0; i < channel->count; ++i) {
+        event_channel_listener* l = &channel->listeners[i];
+        if (l->listener != listener || l->callback != callback) {
+            continue;
+        }
+        if (channel->firing_depth > 0) {
+            // Fires in progress index the list, so only clear the record for now.
+            l->callback = 0;
+            channel->needs_compaction = TRUE;
+        } else {
+            // Shift the rest down to keep registration order.
+            for (u32 j = i + 1; j < channel->count; ++j) {
+                channel->listeners[j - 1] = channel->listeners[j];
+            }
+            channel->count--;
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
+void event_channel_compact(event_channel* channel) {
+    if (channel->firing_depth > 0) {
+        return;
+    }
+    u32 kept = 0;
+    for (u32 i = 0; i < channel->count; ++i) {
+        if (channel->listeners[i].callback) {
+            channel->listeners[kept++] = channel->listeners[i];
+        }
+    }
+    channel->count = kept;
+    channel->needs_compaction = FALSE;
+}
+
+void event_channel_destroy(event_channel* channel) {
+    if (channel->listeners) {
+        kfree(channel->listeners, sizeof(event_channel_listener) * channel->capacity, MEMORY_TAG_ARRAY);
+    }
+    kzero_memory(channel, sizeof(event_channel));
+}
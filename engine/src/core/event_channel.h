@@ -0,0 +1,146 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+Typed event channels. A channel is a statically allocated listener list for one event
+type, declared with a macro that generates functions taking the event struct directly:
+
+    // In a header:
+    EVENT_CHANNEL_DECLARE(player_hit, struct { u32 attacker; u32 victim; f32 damage; });
+    // In exactly one source file:
+    EVENT_CHANNEL_DEFINE(player_hit);
+
+    b8 on_player_hit(void* listener, const player_hit_event* e) { ... }
+    player_hit_register(self, on_player_hit);
+    player_hit_event e = {attacker, victim, 12.5f};
+    player_hit_fire(&e);
+
+which generates:
+    player_hit_event                    The event type.
+    PFN_player_hit_event                b8 (*)(void* listener, const player_hit_event* event)
+    player_hit_register(listener, fn)   As event_register; returns FALSE for duplicates.
+    player_hit_unregister(listener, fn) As event_unregister.
+    player_hit_fire(event)              As event_fire. Inlined at the call site.
+    player_hit_listener_count()
+    player_hit_channel_destroy()        Releases the listener list.
+
+EVENT_CHANNEL(name, type) does both for a channel private to one source file. The
+type is variadic so that struct bodies containing commas can be passed directly.
+
+Fires go straight to the channel's listener list: there is no code lookup, no
+marshalling through event_context and no queue. The common single-listener case is a
+load and one call. Listeners run in registration order and may return TRUE to stop
+propagation. Registering and unregistering from inside a handler are allowed, with the
+same rules as event_register and event_unregister_handle. Channels are main-thread
+only, and their fires are neither profiled, posted nor recorded; use the code-based
+API for events that need any of those.
+*/
+
+// Untyped callback, as stored. Always cast back to the channel's type before calling.
+typedef b8 (*PFN_event_channel_callback)(void* listener, const void* event);
+
+typedef struct event_channel_listener {
+    void* listener;
+    // 0 once unregistered; the record is removed when the channel stops firing.
+    PFN_event_channel_callback callback;
+} event_channel_listener;
+
+typedef struct event_channel {
+    event_channel_listener* listeners;
+    u32 count;
+    u32 capacity;
+    // Number of fires in progress. Listeners are only removed at 0.
+    u32 firing_depth;
+    b8 needs_compaction;
+} event_channel;
+
+/**
+ * Adds a listener to a channel. Prefer the generated <name>_register.
+ * @param channel A pointer to the channel.
+ * @param listener A pointer to a listener instance. Can be 0/NULL.
+ * @param callback The callback, cast to PFN_event_channel_callback.
+ * @returns TRUE if registered; FALSE if the listener/callback combo is already registered.
+ */
+VAPI b8 event_channel_register(event_channel* channel, void* listener, PFN_event_channel_callback callback);
+
+/**
+ * Removes a listener from a channel. Prefer the generated <name>_unregister.
+ * @param channel A pointer to the channel.
+ * @param listener A pointer to a listener instance. Can be 0/NULL.
+ * @param callback The callback, cast to PFN_event_channel_callback.
+ * @returns TRUE if unregistered; FALSE if no matching registration was found.
+ */
+VAPI b8 event_channel_unregister(event_channel* channel, void* listener, PFN_event_channel_callback callback);
+
+// Removes listeners unregistered while the channel was firing. Called by fires as they finish.
+VAPI void event_channel_compact(event_channel* channel);
+
+// Releases a channel's listener list.
+VAPI void event_channel_destroy(event_channel* channel);
+
+// Implementation details of the macros below.
+#define _EVENT_CHANNEL_TYPES(name, ...)                                          \
+    typedef __VA_ARGS__ name##_event;                                             \
+    typedef b8 (*PFN_##name##_event)(void* listener, const name##_event* event);
+
+#define _EVENT_CHANNEL_FUNCTIONS(name)                                                                  \
+    static inline b8 name##_register(void* listener, PFN_##name##_event callback) {                 \
+        return event_channel_register(&name##_channel, listener, (PFN_event_channel_callback)callback); \
+    }                                                                                               \
+    static inline b8 name##_unregister(void* listener, PFN_##name##_event callback) {               \
+        return event_channel_unregister(&name##_channel, listener, (PFN_event_channel_callback)callback); \
+    }                                                                                               \
+    static inline u32 name##_listener_count() {                                                     \
+        return name##_channel.count;                                                                \
+    }                                                                                               \
+    static inline void name##_channel_destroy() {                                                   \
+        event_channel_destroy(&name##_channel);                                                     \
+    }                                                                                               \
+    static inline b8 name##_fire(const name##_event* event) {                                       \
+        event_channel* channel = &name##_channel;                                                   \
+        u32 count = channel->count;                                                                 \
+        if (count == 1 && channel->firing_depth == 0) {                                             \
+            event_channel_listener* l = &channel->listeners[0];                                     \
+            channel->firing_depth++;                                                                \
+            b8 handled = ((PFN_##name##_event)l->callback)(l->listener, event);                     \
+            channel->firing_depth--;                                                                \
+            if (channel->needs_compaction) {                                                        \
+                event_channel_compact(channel);                                                     \
+            }                                                                                       \
+            return handled;                                                                         \
+        }                                                                                           \
+        /* Listeners registered by a handler are not invoked by this fire. The array may */       \
+        /* be reallocated by one, so it is indexed through the channel each time. */                \
+        b8 handled = FALSE;                                                                         \
+        channel->firing_depth++;                                                                    \
+        for (u32 i = 0; i < count; ++i) {                                                           \
+            event_channel_listener l = channel->listeners[i];                                       \
+            if (l.callback && ((PFN_##name##_event)l.callback)(l.listener, event)) {                \
+                handled = TRUE;                                                                     \
+                break;                                                                              \
+            }                                                                                       \
+        }                                                                                           \
+        channel->firing_depth--;                                                                    \
+        if (channel->firing_depth == 0 && channel->needs_compaction) {                              \
+            event_channel_compact(channel);                                                         \
+        }                                                                                           \
+        return handled;                                                                             \
+    }
+
+// Declares a channel and generates its functions. Use in a header, with EVENT_CHANNEL_DEFINE
+// in exactly one source file.
+#define EVENT_CHANNEL_DECLARE(name, ...)     \
+    _EVENT_CHANNEL_TYPES(name, __VA_ARGS__) \
+    extern event_channel name##_channel;    \
+    _EVENT_CHANNEL_FUNCTIONS(name)
+
+// Defines the storage for a channel declared with EVENT_CHANNEL_DECLARE.
+#define EVENT_CHANNEL_DEFINE(name) \
+    event_channel name##_channel = {}
+
+// Declares and defines a channel private to the current source file.
+#define EVENT_CHANNEL(name, ...)                    \
+    _EVENT_CHANNEL_TYPES(name, __VA_ARGS__)        \
+    static event_channel name##_channel = {};      \
+    _EVENT_CHANNEL_FUNCTIONS(name)
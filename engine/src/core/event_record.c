@@ -0,0 +1,298 @@
+#include "core/event_record.h"
+
+#include "core/clock.h"
+#include "core/event.h"
+#include "core/input.h"
+#include "core/logger.h"
+#include "core/mem.h"
+
+#include <stdio.h>
+
+typedef enum event_record_flag {
+    // The event was posted rather than fired.
+    EVENT_RECORD_FLAG_POSTED = 0x1,
+    // Not an event; marks the frame the recording stopped in.
+    EVENT_RECORD_FLAG_END = 0x2,
+    // The record is followed by a payload of context.data.u64[1] bytes.
+    EVENT_RECORD_FLAG_PAYLOAD = 0x4
+} event_record_flag;
+
+// Payloads are padded so records stay aligned.
+#define EVENT_RECORD_PAYLOAD_ALIGNMENT 8
+
+typedef struct event_record {
+    // Frame relative to the start of the recording.
+    u32 frame;
+    u16 code;
+    // A combination of event_record_flag.
+    u8 flags;
+    u8 reserved;
+    // Seconds since the start of the recording.
+    f64 timestamp;
+    event_context context;
+} event_record;
+
+typedef struct event_recorder_state {
+    FILE* file;
+    u64 start_frame;
+    u64 start_time;
+    u64 record_count;
+} event_recorder_state;
+
+typedef struct event_replay_state {
+    // The file contents following the header.
+    u8* data;
+    u64 data_size;
+    // Offset of the next record in data, and the end of the last complete record.
+    u64 next_offset;
+    u64 end_offset;
+    u64 record_count;
+    u64 start_frame;
+    // The frame of the last record; the replay ends after it.
+    u32 last_frame;
+    b8 active;
+} event_replay_state;
+
+static event_recorder_state recorder;
+static event_replay_state replay;
+
+static inline u64 event_record_payload_padded_size(u64 size) {
+    return (size + EVENT_RECORD_PAYLOAD_ALIGNMENT - 1) & ~(u64)(EVENT_RECORD_PAYLOAD_ALIGNMENT - 1);
+}
+
+static b8 event_record_write(u64 frame, u16 code, u8 flags, event_context context, const void* payload) {
+    event_record record;
+    record.frame = (u32)(frame - recorder.start_frame);
+    record.code = code;
+    record.flags = flags;
+    record.reserved = 0;
+    record.timestamp = clock_ns_to_seconds(clock_now_ns() - recorder.start_time);
+    record.context = context;
+    if (!payload) {
+        return fwrite(&record, sizeof(record), 1, recorder.file) == 1;
+    }
+
+    // The pointer means nothing to a replay; the payload is written out instead.
+    u64 size = context.data.u64[1];
+    u64 padding = event_record_payload_padded_size(size) - size;
+    u8 zeros[EVENT_RECORD_PAYLOAD_ALIGNMENT] = {};
+    record.flags |= EVENT_RECORD_FLAG_PAYLOAD;
+    record.context.data.u64[0] = 0;
+    return fwrite(&record, sizeof(record), 1, recorder.file) == 1 &&
+           fwrite(payload, 1, size, recorder.file) == size &&
+           fwrite(zeros, 1, padding, recorder.file) == padding;
+}
+
+static void event_record_capture(u64 frame, u16 code, b8 posted, event_context context, const void* payload) {
+    if (!event_record_write(frame, code, posted ? EVENT_RECORD_FLAG_POSTED : 0, context, payload)) {
+        verror("Failed to write event record; stopping recording.");
+        event_recording_stop();
+        return;
+    }
+    recorder.record_count++;
+}
+
+b8 event_recording_start(const char* path) {
+    if (recorder.file) {
+        vwarn("event_recording_start called while already recording.");
+        return FALSE;
+    }
+    if (replay.active) {
+        // The replayed events would be captured again.
+        vwarn("Cannot record events while replaying.");
+        return FALSE;
+    }
+
+    recorder.file = fopen(path, "wb");
+    if (!recorder.file) {
+        verror("Unable to open event recording '%s' for writing.", path);
+        return FALSE;
+    }
+
+    event_record_header header = {EVENT_RECORD_MAGIC, EVENT_RECORD_VERSION, sizeof(event_record), 0};
+    if (fwrite(&header, sizeof(header), 1, recorder.file) != 1) {
+        verror("Unable to write event recording header to '%s'.", path);
+        fclose(recorder.file);
+        recorder.file = 0;
+        return FALSE;
+    }
+
+    recorder.start_frame = event_frame_number();
+    recorder.start_time = clock_now_ns();
+    recorder.record_count = 0;
+    event_set_capture_hook(event_record_capture);
+    vinfo("Recording events to '%s'.", path);
+    return TRUE;
+}
+
+void event_recording_stop() {
+    if (!recorder.file) {
+        return;
+    }
+    event_set_capture_hook(0);
+    // Mark where recording stopped so a replay runs for the same number of frames, even if
+    // the last ones had no events.
+    event_context empty = {};
+    event_record_write(event_frame_number(), 0, EVENT_RECORD_FLAG_END, empty, 0);
+    fclose(recorder.file);
+    recorder.file = 0;
+    vinfo("Event recording stopped after %llu events.", recorder.record_count);
+}
+
+b8 event_replay_start(const char* path) {
+    if (replay.active || recorder.file) {
+        vwarn("event_replay_start called while already recording or replaying.");
+        return FALSE;
+    }
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        verror("Unable to open event recording '%s'.", path);
+        return FALSE;
+    }
+
+    event_record_header header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != EVENT_RECORD_MAGIC ||
+        header.version != EVENT_RECORD_VERSION || header.record_size != sizeof(event_record)) {
+        verror("'%s' is not a compatible event recording.", path);
+        fclose(file);
+        return FALSE;
+    }
+
+    fseek(file, 0, SEEK_END);
+    i64 file_size = ftell(file);
+    fseek(file, sizeof(header), SEEK_SET);
+    u64 data_size = file_size > (i64)sizeof(header) ? (u64)file_size - sizeof(header) : 0;
+
+    u8* data = 0;
+    if (data_size > 0) {
+        data = kallocate(data_size, MEMORY_TAG_ARRAY);
+        if (fread(data, 1, data_size, file) != data_size) {
+            verror("Failed to read event recording '%s'.", path);
+            kfree(data, data_size, MEMORY_TAG_ARRAY);
+            fclose(file);
+            return FALSE;
+        }
+    }
+    fclose(file);
+
+    // Validate the record chain up front, so replaying never reads out of bounds.
+    u64 record_count = 0;
+    u32 last_frame = 0;
+    u64 offset = 0;
+    while (offset + sizeof(event_record) <= data_size) {
+        const event_record* record = (const event_record*)(data + offset);
+        u64 next = offset + sizeof(event_record);
+        if (record->flags & EVENT_RECORD_FLAG_PAYLOAD) {
+            u64 size = record->context.data.u64[1];
+            if (size > data_size - next || event_record_payload_padded_size(size) > data_size - next) {
+                break;
+            }
+            next += event_record_payload_padded_size(size);
+        }
+        last_frame = record->frame;
+        record_count++;
+        offset = next;
+    }
+    if (offset != data_size) {
+        vwarn("Event recording '%s' is truncated; replaying the first %llu records.", path, record_count);
+    }
+
+    replay.data = data;
+    replay.data_size = data_size;
+    replay.next_offset = 0;
+    replay.end_offset = offset;
+    replay.record_count = record_count;
+    replay.start_frame = event_frame_number();
+    replay.last_frame = last_frame;
+    replay.active = TRUE;
+    vinfo("Replaying %llu records over %u frames from '%s'.", record_count, replay.last_frame + 1, path);
+    return TRUE;
+}
+
+void event_replay_stop() {
+    if (!replay.active) {
+        return;
+    }
+    if (replay.data) {
+        kfree(replay.data, replay.data_size, MEMORY_TAG_ARRAY);
+    }
+    kzero_memory(&replay, sizeof(replay));
+}
+
+b8 event_replay_is_active() {
+    return replay.active;
+}
+
+// Re-issues a recorded event. Input goes through the input system, which updates its
+// state and then posts the event exactly as the platform layer would have.
+static void event_replay_issue(const event_record* record) {
+    const event_context* c = &record->context;
+    if (record->flags & EVENT_RECORD_FLAG_END) {
+        return;
+    }
+    switch (record->code) {
+        case EVENT_CODE_KEY_PRESSED:
+        case EVENT_CODE_KEY_RELEASED:
+            input_process_key((keys)c->data.u16[0], record->code == EVENT_CODE_KEY_PRESSED, c->data.u32[1]);
+            return;
+        case EVENT_CODE_BUTTON_PRESSED:
+        case EVENT_CODE_BUTTON_RELEASED:
+            input_process_button((buttons)c->data.u16[0], record->code == EVENT_CODE_BUTTON_PRESSED, c->data.u32[1]);
+            return;
+        case EVENT_CODE_MOUSE_MOVED:
+            input_process_mouse_move((i16)c->data.u16[0], (i16)c->data.u16[1]);
+            return;
+        case EVENT_CODE_MOUSE_WHEEL:
+            input_process_mouse_wheel((i8)c->data.u8[0]);
+            return;
+        case EVENT_CODE_GAMEPAD_CONNECTION:
+            input_process_gamepad_connection(c->data.u16[0], c->data.u8[2]);
+            return;
+        case EVENT_CODE_GAMEPAD_BUTTON_PRESSED:
+        case EVENT_CODE_GAMEPAD_BUTTON_RELEASED:
+            input_process_gamepad_button(c->data.u16[1], (gamepad_buttons)c->data.u16[0], record->code == EVENT_CODE_GAMEPAD_BUTTON_PRESSED);
+            return;
+        case EVENT_CODE_MOUSE_RAW_MOTION:
+            input_process_mouse_raw_motion(c->data.f32[0], c->data.f32[1]);
+            return;
+        default:
+            break;
+    }
+    if (record->flags & EVENT_RECORD_FLAG_PAYLOAD) {
+        // The payload follows the record; copy it into this frame's payload arena.
+        u64 size = c->data.u64[1];
+        void* payload = event_payload_allocate(size);
+        if (payload) {
+            kcopy_memory(payload, record + 1, size);
+            event_post_payload(record->code, 0, payload, size);
+        }
+    } else if (record->flags & EVENT_RECORD_FLAG_POSTED) {
+        event_post(record->code, 0, record->context);
+    } else {
+        event_fire(record->code, 0, record->context);
+    }
+}
+
+b8 event_replay_pump() {
+    if (!replay.active) {
+        return FALSE;
+    }
+
+    u64 frame = event_frame_number() - replay.start_frame;
+    if (frame > replay.last_frame) {
+        return FALSE;
+    }
+    while (replay.next_offset < replay.end_offset) {
+        const event_record* record = (const event_record*)(replay.data + replay.next_offset);
+        if (record->frame > frame) {
+            break;
+        }
+        event_replay_issue(record);
+        replay.next_offset += sizeof(event_record);
+        if (record->flags & EVENT_RECORD_FLAG_PAYLOAD) {
+            replay.next_offset += event_record_payload_padded_size(record->context.data.u64[1]);
+        }
+    }
+    return TRUE;
+}
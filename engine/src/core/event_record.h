@@ -0,0 +1,60 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+Event recording and deterministic replay.
+
+While recording, every event that enters the event system from outside (see
+PFN_event_capture) is appended to a binary file with its frame number, a timestamp
+and its event_context. Replaying feeds the recorded events back in place of
+platform_pump_messages, frame for frame: input events go through the input system
+so that polled input state matches the recording, and everything else is posted or
+fired the way it originally was. The application shuts down when a replay ends.
+
+File layout, native byte order:
+    event_record_header
+    event_record[count], each followed by its payload, if it has one, zero-padded to a
+    multiple of 8 bytes
+*/
+
+#define EVENT_RECORD_MAGIC 0x52564556  // "VEVR"
+#define EVENT_RECORD_VERSION 2
+
+typedef struct event_record_header {
+    u32 magic;
+    u32 version;
+    // sizeof(event_record) when written, so readers can reject mismatched layouts.
+    u32 record_size;
+    u32 reserved;
+} event_record_header;
+
+/**
+ * Starts recording to the given file, replacing it if it exists.
+ * @param path The path of the file to write.
+ * @returns TRUE if recording started; otherwise FALSE.
+ */
+VAPI b8 event_recording_start(const char* path);
+
+// Stops recording and closes the file. Does nothing if not recording.
+VAPI void event_recording_stop();
+
+/**
+ * Loads a recording and starts replaying it from the next frame.
+ * @param path The path of the recording.
+ * @returns TRUE if the recording was loaded; otherwise FALSE.
+ */
+VAPI b8 event_replay_start(const char* path);
+
+// Stops replaying and releases the recording. Does nothing if not replaying.
+VAPI void event_replay_stop();
+
+// Returns TRUE while a replay is in progress.
+VAPI b8 event_replay_is_active();
+
+/**
+ * Issues the recorded events for the current frame. Called by the application in place
+ * of platform_pump_messages while a replay is active.
+ * @returns FALSE once every recorded frame has been replayed; otherwise TRUE.
+ */
+b8 event_replay_pump();
@@ -0,0 +1,171 @@
+#include "core/frame_limiter.h"
+
+#include "core/clock.h"
+#include "core/logger.h"
+#include "core/mem.h"
+#include "containers/sort.h"
+#include "platform/platform.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define FRAME_LIMITER_RELAX() _mm_pause()
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#define FRAME_LIMITER_RELAX() _mm_pause()
+#else
+#define FRAME_LIMITER_RELAX()
+#endif
+
+// Bounds and starting point for how long before a deadline sleeping stops and spinning starts.
+#define FRAME_LIMITER_SPIN_MIN_NS 100000ULL
+#define FRAME_LIMITER_SPIN_MAX_NS 4000000ULL
+#define FRAME_LIMITER_SPIN_INITIAL_NS 1000000ULL
+
+typedef struct frame_limiter_state {
+    u64 period_ns;
+    // The deadline of the frame in progress, or 0 to start a new schedule.
+    u64 next_deadline;
+    // Smoothed sleep overshoot, and the spin margin derived from it.
+    u64 overshoot_average_ns;
+    u64 spin_margin_ns;
+    u64 missed_frames;
+    // Rolling windows in microseconds, filled in pairs.
+    u32 error_samples[FRAME_LIMITER_SAMPLE_WINDOW];
+    u32 spin_samples[FRAME_LIMITER_SAMPLE_WINDOW];
+    u32 sample_head;
+    u32 sample_count;
+} frame_limiter_state;
+
+static b8 initialized = FALSE;
+static frame_limiter_state state;
+
+void frame_limiter_initialize(u32 target_frame_rate) {
+    kzero_memory(&state, sizeof(state));
+    initialized = TRUE;
+    frame_limiter_set_target(target_frame_rate);
+}
+
+void frame_limiter_shutdown() {
+    initialized = FALSE;
+}
+
+void frame_limiter_set_target(u32 frames_per_second) {
+    if (!initialized) {
+        return;
+    }
+    state.period_ns = frames_per_second ? 1000000000ULL / frames_per_second : 0;
+    state.next_deadline = 0;
+    state.overshoot_average_ns = FRAME_LIMITER_SPIN_INITIAL_NS / 2;
+    state.spin_margin_ns = FRAME_LIMITER_SPIN_INITIAL_NS;
+    state.missed_frames = 0;
+    state.sample_head = 0;
+    state.sample_count = 0;
+    if (frames_per_second) {
+        vinfo("Frame rate limited to %u fps.", frames_per_second);
+    }
+}
+
+u32 frame_limiter_get_target() {
+    return (initialized && state.period_ns) ? (u32)(1000000000ULL / state.period_ns) : 0;
+}
+
+static inline u32 frame_limiter_to_us(u64 ns) {
+    u64 us = (ns + 500) / 1000;
+    return us > 0xFFFFFFFF ? 0xFFFFFFFF : (u32)us;
+}
+
+void frame_limiter_wait() {
+    if (!initialized || !state.period_ns) {
+        return;
+    }
+
+    u64 now = clock_now_ns();
+    if (state.next_deadline == 0) {
+        // The first frame of a schedule has nothing to wait for.
+        state.next_deadline = now + state.period_ns;
+        return;
+    }
+
+    u64 deadline = state.next_deadline;
+    if (now > deadline) {
+        state.missed_frames++;
+        // More than a period behind: start over from now rather than rushing to catch up.
+        state.next_deadline = (now - deadline > state.period_ns) ? now + state.period_ns : deadline + state.period_ns;
+        return;
+    }
+
+    // Sleep until just before the deadline.
+    if (deadline - now > state.spin_margin_ns) {
+        u64 wake_target = deadline - state.spin_margin_ns;
+        platform_sleep_until_ns(wake_target);
+        now = clock_now_ns();
+
+        // Aim the margin at about twice the average overshoot. Overshoot past the deadline
+        // itself counts in full, so a bad wake-up widens the margin quickly.
+        u64 overshoot = now > wake_target ? now - wake_target : 0;
+        state.overshoot_average_ns = (state.overshoot_average_ns * 7 + overshoot) / 8;
+        u64 margin = state.overshoot_average_ns * 2;
+        if (now > deadline && overshoot > margin) {
+            margin = overshoot;
+        }
+        state.spin_margin_ns = margin < FRAME_LIMITER_SPIN_MIN_NS   ? FRAME_LIMITER_SPIN_MIN_NS
+                               : margin > FRAME_LIMITER_SPIN_MAX_NS ? FRAME_LIMITER_SPIN_MAX_NS
+                                                                    : margin;
+    }
+
+    // Spin the remainder.
+    u64 spin_start = now;
+    while (now < deadline) {
+        FRAME_LIMITER_RELAX();
+        now = clock_now_ns();
+    }
+
+    state.error_samples[state.sample_head] = frame_limiter_to_us(now - deadline);
+    state.spin_samples[state.sample_head] = frame_limiter_to_us(now - spin_start);
+    state.sample_head = (state.sample_head + 1) % FRAME_LIMITER_SAMPLE_WINDOW;
+    if (state.sample_count < FRAME_LIMITER_SAMPLE_WINDOW) {
+        state.sample_count++;
+    }
+
+    state.next_deadline = deadline + state.period_ns;
+}
+
+void frame_limiter_get_stats(frame_limiter_stats* out_stats) {
+    kzero_memory(out_stats, sizeof(frame_limiter_stats));
+    if (!initialized) {
+        return;
+    }
+    out_stats->missed_frames = state.missed_frames;
+    u32 count = state.sample_count;
+    out_stats->sample_count = count;
+    if (count == 0) {
+        return;
+    }
+
+    u32 sorted[FRAME_LIMITER_SAMPLE_WINDOW];
+    u32 scratch[FRAME_LIMITER_SAMPLE_WINDOW];
+    kcopy_memory(sorted, state.error_samples, sizeof(u32) * count);
+    radix_sort_u32(sorted, 0, count, scratch, 0);
+    // Nearest-rank percentiles.
+    out_stats->error_p50_us = sorted[(u32)(0.50 * count + 0.999999) - 1];
+    out_stats->error_p99_us = sorted[(u32)(0.99 * count + 0.999999) - 1];
+    out_stats->error_max_us = sorted[count - 1];
+
+    u64 spin_total = 0;
+    for (u32 i = 0; i < count; ++i) {
+        spin_total += state.spin_samples[i];
+    }
+    out_stats->spin_mean_us = (f64)spin_total / count;
+}
+
+void frame_limiter_report() {
+    frame_limiter_stats stats;
+    frame_limiter_get_stats(&stats);
+    if (stats.sample_count == 0) {
+        vinfo("Frame pacing: no limited frames yet.");
+        return;
+    }
+    vinfo("Frame pacing over %u frames at %u fps: deadline error p50 %.0fus, p99 %.0fus, max %.0fus; spin %.0fus/frame; %llu missed",
+          stats.sample_count, frame_limiter_get_target(), stats.error_p50_us, stats.error_p99_us, stats.error_max_us,
+          stats.spin_mean_us, stats.missed_frames);
+}
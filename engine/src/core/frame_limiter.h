@@ -0,0 +1,54 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+Frame pacing. With a target frame rate set, each frame is held until its deadline:
+the thread sleeps on an absolute deadline until shortly before it, then spins for
+the remainder, as the OS wakes sleeping threads tens to hundreds of microseconds
+late. The spin margin adapts to the wake-up overshoot actually observed, so the
+spin stays short and most of the wait gives the core back to the OS.
+
+Deadlines advance by exactly one period from the previous deadline, so errors do
+not accumulate into drift. A frame that overruns its deadline by more than a period
+is counted as missed and the schedule restarts from it, rather than rushing the
+following frames to catch up.
+*/
+
+// The number of frames over which deadline error percentiles are computed.
+#define FRAME_LIMITER_SAMPLE_WINDOW 512
+
+typedef struct frame_limiter_stats {
+    // The number of frames in the window.
+    u32 sample_count;
+    // How late frames were released relative to their deadlines, in microseconds.
+    f64 error_p50_us;
+    f64 error_p99_us;
+    f64 error_max_us;
+    // Mean time spent spinning per frame, in microseconds.
+    f64 spin_mean_us;
+    // Frames, since the target was set, that were not ready until after their deadline.
+    u64 missed_frames;
+} frame_limiter_stats;
+
+void frame_limiter_initialize(u32 target_frame_rate);
+void frame_limiter_shutdown();
+
+// Waits until the current frame's deadline, then schedules the next. Returns immediately
+// if no target is set. Called by the application once per frame.
+void frame_limiter_wait();
+
+/**
+ * Sets the frame rate frames are held to.
+ * @param frames_per_second The target rate, or 0 to run unlimited.
+ */
+VAPI void frame_limiter_set_target(u32 frames_per_second);
+
+// Returns the target frame rate, or 0 if unlimited.
+VAPI u32 frame_limiter_get_target();
+
+// Computes deadline error percentiles over the most recent limited frames.
+VAPI void frame_limiter_get_stats(frame_limiter_stats* out_stats);
+
+// Logs the current deadline error percentiles.
+VAPI void frame_limiter_report();
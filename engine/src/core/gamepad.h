@@ -0,0 +1,56 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+Gamepad types shared by the input system and the platform backends. Kept apart from
+input.h so that backends can use them alongside OS headers whose key names clash
+with the keys enum (e.g. linux/input.h).
+*/
+
+// Gamepad buttons, named by position on an Xbox-style layout.
+typedef enum gamepad_buttons {
+    // Bottom face button.
+    GAMEPAD_BUTTON_A,
+    // Right face button.
+    GAMEPAD_BUTTON_B,
+    // Left face button.
+    GAMEPAD_BUTTON_X,
+    // Top face button.
+    GAMEPAD_BUTTON_Y,
+    GAMEPAD_BUTTON_LEFT_SHOULDER,
+    GAMEPAD_BUTTON_RIGHT_SHOULDER,
+    GAMEPAD_BUTTON_BACK,
+    GAMEPAD_BUTTON_START,
+    GAMEPAD_BUTTON_GUIDE,
+    GAMEPAD_BUTTON_LEFT_STICK,
+    GAMEPAD_BUTTON_RIGHT_STICK,
+    GAMEPAD_BUTTON_DPAD_UP,
+    GAMEPAD_BUTTON_DPAD_DOWN,
+    GAMEPAD_BUTTON_DPAD_LEFT,
+    GAMEPAD_BUTTON_DPAD_RIGHT,
+    GAMEPAD_BUTTON_MAX_BUTTONS
+} gamepad_buttons;
+
+typedef enum gamepad_axes {
+    // Sticks range from -1 to 1, positive right and down.
+    GAMEPAD_AXIS_LEFT_X,
+    GAMEPAD_AXIS_LEFT_Y,
+    GAMEPAD_AXIS_RIGHT_X,
+    GAMEPAD_AXIS_RIGHT_Y,
+    // Triggers range from 0 to 1.
+    GAMEPAD_AXIS_LEFT_TRIGGER,
+    GAMEPAD_AXIS_RIGHT_TRIGGER,
+    GAMEPAD_AXIS_MAX_AXES
+} gamepad_axes;
+
+// The number of gamepads tracked at once.
+#define INPUT_MAX_GAMEPADS 4
+
+// A snapshot of a gamepad, as delivered by the platform layer.
+typedef struct gamepad_state {
+    b8 connected;
+    // Bit i is set while gamepad_buttons i is down.
+    u32 buttons;
+    f32 axes[GAMEPAD_AXIS_MAX_AXES];
+} gamepad_state;
@@ -0,0 +1,414 @@
+#include "core/hash.h"
+
+#include "core/mem.h"
+#include "core/logger.h"
+#include "core/cpu.h"
+#include "core/clock.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define HASH_X86 1
+#include <immintrin.h>
+#endif
+
+// NOTE: Reads assume a little-endian host, which covers every supported platform.
+
+// wyhash constants.
+static const u64 hash_secret[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL};
+
+// Per-lane keys for the striped path. Stripe n uses keys [n % 16, n % 16 + 8).
+#define STRIPE_SIZE 64
+#define STRIPES_PER_BLOCK 16
+static const u64 stripe_keys[STRIPES_PER_BLOCK + 8] = {
+    0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL,
+    0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL, 0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL,
+    0xcb00c391bb52283cULL, 0xa32e531b8b65d088ULL, 0x4ef90da297486471ULL, 0xd8acdea946ef1938ULL,
+    0x3f349ce33f76faa8ULL, 0x1d4f0bc7c7bbdcf9ULL, 0x3159b4cd4be0518aULL, 0x647378d9c97e9fc8ULL,
+    0xc3ebd33483acc5eaULL, 0xeb6313faffa081c5ULL, 0x49daf0b751dd0d17ULL, 0x9e68d429265516d3ULL,
+    0xfca1477d58be162bULL, 0xce31d07ad1b8f88fULL, 0x280416958f3acb45ULL, 0x7e404bbbcafbd7afULL};
+// Keys used for the final stripe, which may overlap the previous one.
+static const u64 last_stripe_keys[8] = {
+    0x7378d9c97e9fc831ULL, 0xebd33483acc5ea64ULL, 0x6313faffa081c5c3ULL, 0xdaf0b751dd0d17ebULL,
+    0x68d429265516d349ULL, 0xa1477d58be162b9eULL, 0x31d07ad1b8f88ffcULL, 0x0416958f3acb45ceULL};
+#define SCRAMBLE_PRIME 0x9e3779b1U
+
+static inline u64 read_u64(const u8* p) {
+    u64 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline u64 read_u32(const u8* p) {
+    u32 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline u64 read_small(const u8* p, u64 k) {
+    return (((u64)p[0]) << 16) | (((u64)p[k >> 1]) << 8) | p[k - 1];
+}
+
+static inline void mum(u64* a, u64* b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (u64)r;
+    *b = (u64)(r >> 64);
+#else
+    u64 ha = *a >> 32, hb = *b >> 32, la = (u32)*a, lb = (u32)*b;
+    u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    u64 t = rl + (rm0 << 32);
+    u64 c = t < rl;
+    u64 lo = t + (rm1 << 32);
+    c += lo < t;
+    u64 hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    *a = lo;
+    *b = hi;
+#endif
+}
+
+static inline u64 mix(u64 a, u64 b) {
+    mum(&a, &b);
+    return a ^ b;
+}
+
+static u64 hash_short(const u8* p, u64 length, u64 seed) {
+    seed ^= mix(seed ^ hash_secret[0], hash_secret[1]);
+    u64 a, b;
+    if (length <= 16) {
+        if (length >= 4) {
+            a = (read_u32(p) << 32) | read_u32(p + ((length >> 3) << 2));
+            b = (read_u32(p + length - 4) << 32) | read_u32(p + length - 4 - ((length >> 3) << 2));
+        } else if (length > 0) {
+            a = read_small(p, length);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        u64 i = length;
+        if (i > 48) {
+            u64 see1 = seed, see2 = seed;
+            do {
+                seed = mix(read_u64(p) ^ hash_secret[1], read_u64(p + 8) ^ seed);
+                see1 = mix(read_u64(p + 16) ^ hash_secret[2], read_u64(p + 24) ^ see1);
+                see2 = mix(read_u64(p + 32) ^ hash_secret[3], read_u64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = mix(read_u64(p) ^ hash_secret[1], read_u64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = read_u64(p + i - 16);
+        b = read_u64(p + i - 8);
+    }
+    a ^= hash_secret[1];
+    b ^= seed;
+    mum(&a, &b);
+    return mix(a ^ hash_secret[0] ^ length, b ^ hash_secret[1]);
+}
+
+// Striped accumulation kernels. Each consumes a run of stripes, scrambling the
+// accumulators after every STRIPES_PER_BLOCK stripes. All variants produce identical results.
+typedef void (*PFN_consume_stripes)(u64* acc, u64* stripe_index, const u8* data, u64 stripe_count, u64 seed);
+
+static inline void accumulate_stripe_scalar(u64* acc, const u8* stripe, const u64* keys, u64 seed) {
+    for (u32 i = 0; i < 8; ++i) {
+        u64 d = read_u64(stripe + i * 8);
+        u64 k = d ^ keys[i] ^ seed;
+        acc[i ^ 1] += d;
+        acc[i] += (u64)(u32)k * (k >> 32);
+    }
+}
+
+static void consume_stripes_scalar(u64* acc, u64* stripe_index, const u8* data, u64 stripe_count, u64 seed) {
+    u64 a[8];
+    memcpy(a, acc, sizeof(a));
+    u64 index = *stripe_index;
+    for (u64 n = 0; n < stripe_count; ++n) {
+        accumulate_stripe_scalar(a, data + n * STRIPE_SIZE, stripe_keys + index, seed);
+        if (++index == STRIPES_PER_BLOCK) {
+            for (u32 i = 0; i < 8; ++i) {
+                a[i] ^= a[i] >> 47;
+                a[i] ^= stripe_keys[STRIPES_PER_BLOCK + i] ^ seed;
+                a[i] *= SCRAMBLE_PRIME;
+            }
+            index = 0;
+        }
+    }
+    memcpy(acc, a, sizeof(a));
+    *stripe_index = index;
+}
+
+#if HASH_X86
+static inline __m128i accumulate_sse2(__m128i a, const u8* p, const u64* keys, __m128i s) {
+    __m128i d = _mm_loadu_si128((const __m128i*)p);
+    __m128i k = _mm_xor_si128(_mm_xor_si128(d, _mm_loadu_si128((const __m128i*)keys)), s);
+    __m128i product = _mm_mul_epu32(k, _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1)));
+    __m128i swapped = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+    return _mm_add_epi64(a, _mm_add_epi64(product, swapped));
+}
+
+static inline __m128i scramble_sse2(__m128i a, const u64* keys, __m128i s, __m128i prime) {
+    a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+    a = _mm_xor_si128(a, _mm_xor_si128(_mm_loadu_si128((const __m128i*)keys), s));
+    __m128i lo = _mm_mul_epu32(a, prime);
+    __m128i hi = _mm_mul_epu32(_mm_srli_epi64(a, 32), prime);
+    return _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+}
+
+static void consume_stripes_sse2(u64* acc, u64* stripe_index, const u8* data, u64 stripe_count, u64 seed) {
+    __m128i s = _mm_set1_epi64x((i64)seed);
+    __m128i prime = _mm_set1_epi32((i32)SCRAMBLE_PRIME);
+    __m128i a0 = _mm_loadu_si128((const __m128i*)acc + 0);
+    __m128i a1 = _mm_loadu_si128((const __m128i*)acc + 1);
+    __m128i a2 = _mm_loadu_si128((const __m128i*)acc + 2);
+    __m128i a3 = _mm_loadu_si128((const __m128i*)acc + 3);
+    u64 index = *stripe_index;
+    for (u64 n = 0; n < stripe_count; ++n) {
+        const u8* p = data + n * STRIPE_SIZE;
+        const u64* keys = stripe_keys + index;
+        a0 = accumulate_sse2(a0, p, keys, s);
+        a1 = accumulate_sse2(a1, p + 16, keys + 2, s);
+        a2 = accumulate_sse2(a2, p + 32, keys + 4, s);
+        a3 = accumulate_sse2(a3, p + 48, keys + 6, s);
+        if (++index == STRIPES_PER_BLOCK) {
+            const u64* scramble_keys = stripe_keys + STRIPES_PER_BLOCK;
+            a0 = scramble_sse2(a0, scramble_keys, s, prime);
+            a1 = scramble_sse2(a1, scramble_keys + 2, s, prime);
+            a2 = scramble_sse2(a2, scramble_keys + 4, s, prime);
+            a3 = scramble_sse2(a3, scramble_keys + 6, s, prime);
+            index = 0;
+        }
+    }
+    _mm_storeu_si128((__m128i*)acc + 0, a0);
+    _mm_storeu_si128((__m128i*)acc + 1, a1);
+    _mm_storeu_si128((__m128i*)acc + 2, a2);
+    _mm_storeu_si128((__m128i*)acc + 3, a3);
+    *stripe_index = index;
+}
+
+#if defined(__GNUC__)
+__attribute__((target("avx2"))) static inline __m256i accumulate_avx2(__m256i a, const u8* p, const u64* keys, __m256i s) {
+    __m256i d = _mm256_loadu_si256((const __m256i*)p);
+    __m256i k = _mm256_xor_si256(_mm256_xor_si256(d, _mm256_loadu_si256((const __m256i*)keys)), s);
+    __m256i product = _mm256_mul_epu32(k, _mm256_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1)));
+    __m256i swapped = _mm256_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+    return _mm256_add_epi64(a, _mm256_add_epi64(product, swapped));
+}
+
+__attribute__((target("avx2"))) static inline __m256i scramble_avx2(__m256i a, const u64* keys, __m256i s, __m256i prime) {
+    a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+    a = _mm256_xor_si256(a, _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)keys), s));
+    __m256i lo = _mm256_mul_epu32(a, prime);
+    __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+}
+
+__attribute__((target("avx2"))) static void consume_stripes_avx2(u64* acc, u64* stripe_index, const u8* data, u64 stripe_count, u64 seed) {
+    __m256i s = _mm256_set1_epi64x((i64)seed);
+    __m256i prime = _mm256_set1_epi32((i32)SCRAMBLE_PRIME);
+    __m256i a0 = _mm256_loadu_si256((const __m256i*)acc + 0);
+    __m256i a1 = _mm256_loadu_si256((const __m256i*)acc + 1);
+    u64 index = *stripe_index;
+    for (u64 n = 0; n < stripe_count; ++n) {
+        const u8* p = data + n * STRIPE_SIZE;
+        const u64* keys = stripe_keys + index;
+        a0 = accumulate_avx2(a0, p, keys, s);
+        a1 = accumulate_avx2(a1, p + 32, keys + 4, s);
+        if (++index == STRIPES_PER_BLOCK) {
+            a0 = scramble_avx2(a0, stripe_keys + STRIPES_PER_BLOCK, s, prime);
+            a1 = scramble_avx2(a1, stripe_keys + STRIPES_PER_BLOCK + 4, s, prime);
+            index = 0;
+        }
+    }
+    _mm256_storeu_si256((__m256i*)acc + 0, a0);
+    _mm256_storeu_si256((__m256i*)acc + 1, a1);
+    *stripe_index = index;
+}
+#endif
+#endif
+
+static PFN_consume_stripes consume_stripes_kernel = 0;
+
+static void select_kernel() {
+    consume_stripes_kernel = consume_stripes_scalar;
+#if HASH_X86
+    consume_stripes_kernel = consume_stripes_sse2;
+#if defined(__GNUC__)
+    if (cpu_has_feature(CPU_FEATURE_AVX2)) {
+        consume_stripes_kernel = consume_stripes_avx2;
+    }
+#endif
+#endif
+}
+
+static void init_accumulators(u64* acc, u64 seed) {
+    acc[0] = hash_secret[0] ^ seed;
+    acc[1] = hash_secret[1];
+    acc[2] = hash_secret[2] + seed;
+    acc[3] = hash_secret[3];
+    acc[4] = hash_secret[0] - seed;
+    acc[5] = hash_secret[1] ^ (seed << 1);
+    acc[6] = hash_secret[2];
+    acc[7] = hash_secret[3] + (seed >> 1);
+}
+
+static void consume_stripes(u64* acc, u64* stripe_index, const u8* data, u64 stripe_count, u64 seed) {
+    if (!consume_stripes_kernel) {
+        select_kernel();
+    }
+    consume_stripes_kernel(acc, stripe_index, data, stripe_count, seed);
+}
+
+static u64 finalize_long(u64* acc, const u8* last_stripe, u64 length, u64 seed) {
+    accumulate_stripe_scalar(acc, last_stripe, last_stripe_keys, seed);
+
+    u64 result = length * 0x9e3779b97f4a7c15ULL ^ seed;
+    for (u32 i = 0; i < 8; i += 2) {
+        result += mix(acc[i] ^ stripe_keys[i + 3], acc[i + 1] ^ stripe_keys[i + 4]);
+    }
+
+    // Avalanche.
+    result ^= result >> 37;
+    result *= 0x165667919e3779f9ULL;
+    result ^= result >> 32;
+    return result;
+}
+
+static u64 hash_long(const u8* p, u64 length, u64 seed) {
+    u64 acc[8];
+    u64 stripe_index = 0;
+    init_accumulators(acc, seed);
+    // Every full stripe except the one holding the last byte is consumed normally.
+    consume_stripes(acc, &stripe_index, p, (length - 1) / STRIPE_SIZE, seed);
+    return finalize_long(acc, p + length - STRIPE_SIZE, length, seed);
+}
+
+u64 hash_bytes(const void* data, u64 length, u64 seed) {
+    if (length <= HASH_SHORT_MAX) {
+        return hash_short((const u8*)data, length, seed);
+    }
+    return hash_long((const u8*)data, length, seed);
+}
+
+u64 hash_string(const char* str, u64 seed) {
+    return hash_bytes(str, strlen(str), seed);
+}
+
+u64 hash_combine(u64 a, u64 b) {
+    return mix(a ^ hash_secret[0], b ^ hash_secret[1]);
+}
+
+void hash_stream_begin(hash_state* state, u64 seed) {
+    kzero_memory(state, sizeof(hash_state));
+    state->seed = seed;
+    init_accumulators(state->acc, seed);
+}
+
+void hash_stream_update(hash_state* state, const void* data, u64 length) {
+    const u8* p = (const u8*)data;
+    state->total_length += length;
+
+    if (state->buffered + length <= HASH_SHORT_MAX) {
+        memcpy(state->buffer + state->buffered, p, length);
+        state->buffered += length;
+        return;
+    }
+
+    // More input follows whatever is consumed here, so the final stripe is never
+    // consumed early.
+    if (state->buffered > 0) {
+        u64 fill = HASH_SHORT_MAX - state->buffered;
+        memcpy(state->buffer + state->buffered, p, fill);
+        p += fill;
+        length -= fill;
+        consume_stripes(state->acc, &state->stripe_index, state->buffer, HASH_SHORT_MAX / STRIPE_SIZE, state->seed);
+        state->buffered = 0;
+    }
+
+    if (length > HASH_SHORT_MAX) {
+        while (length > HASH_SHORT_MAX) {
+            consume_stripes(state->acc, &state->stripe_index, p, HASH_SHORT_MAX / STRIPE_SIZE, state->seed);
+            p += HASH_SHORT_MAX;
+            length -= HASH_SHORT_MAX;
+        }
+        // Keep the last consumed stripe at the end of the buffer for digest.
+        memcpy(state->buffer + HASH_SHORT_MAX - STRIPE_SIZE, p - STRIPE_SIZE, STRIPE_SIZE);
+    }
+
+    memcpy(state->buffer, p, length);
+    state->buffered = length;
+}
+
+u64 hash_stream_digest(const hash_state* state) {
+    if (state->total_length <= HASH_SHORT_MAX) {
+        return hash_short(state->buffer, state->total_length, state->seed);
+    }
+
+    u64 acc[8];
+    memcpy(acc, state->acc, sizeof(acc));
+    u64 stripe_index = state->stripe_index;
+    consume_stripes(acc, &stripe_index, state->buffer, (state->buffered - 1) / STRIPE_SIZE, state->seed);
+
+    if (state->buffered >= STRIPE_SIZE) {
+        return finalize_long(acc, state->buffer + state->buffered - STRIPE_SIZE, state->total_length, state->seed);
+    }
+
+    // The final stripe straddles previously-consumed input kept at the end of the buffer.
+    u8 last_stripe[STRIPE_SIZE];
+    u64 carried = STRIPE_SIZE - state->buffered;
+    memcpy(last_stripe, state->buffer + HASH_SHORT_MAX - carried, carried);
+    memcpy(last_stripe + carried, state->buffer, state->buffered);
+    return finalize_long(acc, last_stripe, state->total_length, state->seed);
+}
+
+u64 hash_fnv1a_64(const void* data, u64 length) {
+    const u8* p = (const u8*)data;
+    u64 hash = 0xcbf29ce484222325ULL;
+    for (u64 i = 0; i < length; ++i) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+void hash_benchmark(u64 max_size) {
+    u8* data = kallocate(max_size, MEMORY_TAG_ARRAY);
+    for (u64 i = 0; i < max_size; ++i) {
+        data[i] = (u8)(i * 131 + (i >> 8));
+    }
+
+    // Measure each size over roughly the same number of bytes.
+    const u64 bytes_per_size = 256ULL * 1024 * 1024;
+    vinfo("Hash throughput (hash_bytes vs FNV-1a):");
+    for (u64 size = 8; size <= max_size; size *= 4) {
+        u64 iterations = bytes_per_size / size;
+        // Chain results through the seed so nothing can be hoisted out of the loop.
+        u64 sink = 0;
+
+        u64 start = clock_now_ns();
+        for (u64 i = 0; i < iterations; ++i) {
+            sink = hash_bytes(data, size, sink);
+        }
+        f64 fast_seconds = clock_ns_to_seconds(clock_now_ns() - start);
+
+        start = clock_now_ns();
+        for (u64 i = 0; i < iterations; ++i) {
+            data[0] = (u8)sink;
+            sink ^= hash_fnv1a_64(data, size);
+        }
+        f64 fnv_seconds = clock_ns_to_seconds(clock_now_ns() - start);
+
+        f64 gib = (f64)(iterations * size) / (1024.0 * 1024.0 * 1024.0);
+        vinfo("  %8llu B: %7.2f GiB/s vs %6.2f GiB/s (%5.1fx) [%llx]",
+              size, gib / fast_seconds, gib / fnv_seconds, fnv_seconds / fast_seconds, sink & 0xff);
+    }
+
+    kfree(data, max_size, MEMORY_TAG_ARRAY);
+}
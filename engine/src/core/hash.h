@@ -0,0 +1,73 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+Fast, stable, non-cryptographic 64-bit hashing.
+
+Inputs up to HASH_SHORT_MAX bytes use a wyhash-style multiply-mix, which has very
+low fixed cost for the keys that dominate table lookups (names, small structs).
+Longer inputs are split into 64-byte stripes accumulated into eight independent
+64-bit lanes, in the manner of XXH3, which maps directly onto SSE2/AVX2 and is
+selected at runtime where available. The output is identical on every path and
+across runs, so it is suitable for persistent keys such as shader cache entries
+and asset content addresses. Must not be used where an adversary controls input
+and collisions matter.
+
+The streaming API produces the same value as a one-shot hash over the
+concatenation of all updates.
+*/
+
+// The input size at and below which the short path is used.
+#define HASH_SHORT_MAX 256
+
+// Hash state for streaming input.
+typedef struct hash_state {
+    u64 acc[8];
+    // Holds the most recent unconsumed input. Once input exceeds HASH_SHORT_MAX, the
+    // bytes preceding the unconsumed ones are kept at the end for the final stripe.
+    u8 buffer[HASH_SHORT_MAX];
+    u64 buffered;
+    u64 total_length;
+    u64 stripe_index;
+    u64 seed;
+} hash_state;
+
+/**
+ * Hashes a block of bytes.
+ * @param data The data to hash. Can be 0/NULL if length is 0.
+ * @param length The length of the data in bytes.
+ * @param seed The seed. Different seeds produce unrelated hashes.
+ * @returns The 64-bit hash.
+ */
+VAPI u64 hash_bytes(const void* data, u64 length, u64 seed);
+
+/**
+ * Hashes a zero-terminated string, excluding the terminator.
+ * @param str The string to hash.
+ * @param seed The seed.
+ * @returns The 64-bit hash.
+ */
+VAPI u64 hash_string(const char* str, u64 seed);
+
+// Combines two hashes into one. Order-dependent.
+VAPI u64 hash_combine(u64 a, u64 b);
+
+// Begins a streaming hash with the given seed.
+VAPI void hash_stream_begin(hash_state* state, u64 seed);
+
+// Appends data to a streaming hash.
+VAPI void hash_stream_update(hash_state* state, const void* data, u64 length);
+
+// Returns the hash of all data appended so far. The state may continue to be updated.
+VAPI u64 hash_stream_digest(const hash_state* state);
+
+// FNV-1a, kept as a simple reference and baseline for benchmarking.
+VAPI u64 hash_fnv1a_64(const void* data, u64 length);
+
+/**
+ * Measures and logs the throughput of hash_bytes and the FNV-1a baseline over a
+ * range of input sizes, up to the given maximum.
+ * @param max_size The largest input size to measure, in bytes.
+ */
+VAPI void hash_benchmark(u64 max_size);
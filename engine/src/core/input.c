@@ -2,6 +2,7 @@
 #include "core/event.h"
 #include "core/mem.h"
 #include "core/logger.h"
+#include "core/latency.h"
 
 typedef struct keyboard_state {
     b8 keys[256];
@@ -13,11 +14,27 @@ typedef struct mouse_state {
     u8 buttons[BUTTON_MAX_BUTTONS];
 } mouse_state;
 
+typedef struct mouse_raw_state {
+    b8 available;
+    // Motion since the last update. Summed in double precision so that many small
+    // high-rate deltas do not lose their fractional parts.
+    f64 dx;
+    f64 dy;
+} mouse_raw_state;
+
 typedef struct input_state {
     keyboard_state keyboard_current;
     keyboard_state keyboard_previous;
     mouse_state mouse_current;
     mouse_state mouse_previous;
+    mouse_raw_state mouse_raw;
+    gamepad_state gamepads_current[INPUT_MAX_GAMEPADS];
+    gamepad_state gamepads_previous[INPUT_MAX_GAMEPADS];
+    // Transitions since the last update.
+    input_key_event key_events[INPUT_EVENT_BUFFER_CAPACITY];
+    u32 key_event_count;
+    input_button_event button_events[INPUT_EVENT_BUFFER_CAPACITY];
+    u32 button_event_count;
 } input_state;
 
 // Internal input state
@@ -43,30 +60,55 @@ void input_update(f64 delta_time) {
     // Copy current states to previous states.
     kcopy_memory(&state.keyboard_previous, &state.keyboard_current, sizeof(keyboard_state));
     kcopy_memory(&state.mouse_previous, &state.mouse_current, sizeof(mouse_state));
+    kcopy_memory(state.gamepads_previous, state.gamepads_current, sizeof(state.gamepads_current));
+
+    // Start collecting the next frame's transitions.
+    state.key_event_count = 0;
+    state.button_event_count = 0;
+    state.mouse_raw.dx = 0;
+    state.mouse_raw.dy = 0;
 }
 
-void input_process_key(keys key, b8 pressed) {
+void input_process_key(keys key, b8 pressed, u32 timestamp) {
     // Only handle this if the state actually changed.
     if (state.keyboard_current.keys[key] != pressed) {
         // Update internal state.
         state.keyboard_current.keys[key] = pressed;
+        latency_input_received();
+
+        if (state.key_event_count < INPUT_EVENT_BUFFER_CAPACITY) {
+            input_key_event* e = &state.key_events[state.key_event_count++];
+            e->key = key;
+            e->pressed = pressed;
+            e->timestamp = timestamp;
+        }
 
-        // Fire off an event for immediate processing.
-        event_context context;
+        // Post an event, dispatched in order with other input at the start of the frame.
+        event_context context = {};
         context.data.u16[0] = key;
-        event_fire(pressed ? EVENT_CODE_KEY_PRESSED : EVENT_CODE_KEY_RELEASED, 0, context);
+        context.data.u32[1] = timestamp;
+        event_post(pressed ? EVENT_CODE_KEY_PRESSED : EVENT_CODE_KEY_RELEASED, 0, context);
     }
 }
 
-void input_process_button(buttons button, b8 pressed) {
+void input_process_button(buttons button, b8 pressed, u32 timestamp) {
     // If the state changed, fire an event.
     if (state.mouse_current.buttons[button] != pressed) {
         state.mouse_current.buttons[button] = pressed;
+        latency_input_received();
 
-        // Fire the event.
-        event_context context;
+        if (state.button_event_count < INPUT_EVENT_BUFFER_CAPACITY) {
+            input_button_event* e = &state.button_events[state.button_event_count++];
+            e->button = button;
+            e->pressed = pressed;
+            e->timestamp = timestamp;
+        }
+
+        // Post the event.
+        event_context context = {};
         context.data.u16[0] = button;
-        event_fire(pressed ? EVENT_CODE_BUTTON_PRESSED : EVENT_CODE_BUTTON_RELEASED, 0, context);
+        context.data.u32[1] = timestamp;
+        event_post(pressed ? EVENT_CODE_BUTTON_PRESSED : EVENT_CODE_BUTTON_RELEASED, 0, context);
     }
 }
 
@@ -79,22 +121,40 @@ void input_process_mouse_move(i16 x, i16 y) {
         // Update internal state.
         state.mouse_current.x = x;
         state.mouse_current.y = y;
+        latency_input_received();
 
-        // Fire the event.
-        event_context context;
+        // Post the event. Moves are coalesced to the latest position each frame.
+        event_context context = {};
         context.data.u16[0] = x;
         context.data.u16[1] = y;
-        event_fire(EVENT_CODE_MOUSE_MOVED, 0, context);
+        event_post(EVENT_CODE_MOUSE_MOVED, 0, context);
     }
 }
 
 void input_process_mouse_wheel(i8 z_delta) {
     // NOTE: no internal state to update.
+    latency_input_received();
 
-    // Fire the event.
-    event_context context;
+    // Post the event.
+    event_context context = {};
     context.data.u8[0] = z_delta;
-    event_fire(EVENT_CODE_MOUSE_WHEEL, 0, context);
+    event_post(EVENT_CODE_MOUSE_WHEEL, 0, context);
+}
+
+void input_process_mouse_raw_motion(f32 dx, f32 dy) {
+    state.mouse_raw.dx += dx;
+    state.mouse_raw.dy += dy;
+    latency_input_received();
+
+    // Post the event. Raw motion is summed into one event per frame.
+    event_context context = {};
+    context.data.f32[0] = dx;
+    context.data.f32[1] = dy;
+    event_post(EVENT_CODE_MOUSE_RAW_MOTION, 0, context);
+}
+
+void input_set_raw_mouse_motion_available(b8 available) {
+    state.mouse_raw.available = available;
 }
 
 b8 input_is_key_down(keys key) {
@@ -125,6 +185,24 @@ b8 input_was_key_up(keys key) {
     return state.keyboard_previous.keys[key] == FALSE;
 }
 
+u32 input_get_key_events(const input_key_event** out_events) {
+    *out_events = state.key_events;
+    return initialized ? state.key_event_count : 0;
+}
+
+u32 input_get_key_press_count(keys key) {
+    if (!initialized) {
+        return 0;
+    }
+    u32 count = 0;
+    for (u32 i = 0; i < state.key_event_count; ++i) {
+        if (state.key_events[i].key == key && state.key_events[i].pressed) {
+            count++;
+        }
+    }
+    return count;
+}
+
 // mouse input
 b8 input_is_button_down(buttons button) {
     if (!initialized) {
@@ -172,4 +250,114 @@ void input_get_previous_mouse_position(i32* x, i32* y) {
     }
     *x = state.mouse_previous.x;
     *y = state.mouse_previous.y;
-}
\ No newline at end of file
+}
+
+u32 input_get_button_events(const input_button_event** out_events) {
+    *out_events = state.button_events;
+    return initialized ? state.button_event_count : 0;
+}
+
+void input_get_mouse_raw_delta(f32* dx, f32* dy) {
+    if (!initialized) {
+        *dx = 0;
+        *dy = 0;
+        return;
+    }
+    *dx = (f32)state.mouse_raw.dx;
+    *dy = (f32)state.mouse_raw.dy;
+}
+
+b8 input_has_raw_mouse_motion() {
+    return initialized && state.mouse_raw.available;
+}
+
+void input_process_gamepad(u32 index, const gamepad_state* gamepad) {
+    if (index >= INPUT_MAX_GAMEPADS) {
+        return;
+    }
+    gamepad_state* current = &state.gamepads_current[index];
+    input_process_gamepad_connection(index, gamepad->connected);
+
+    u32 changed = current->buttons ^ gamepad->buttons;
+    while (changed) {
+        u32 button = (u32)__builtin_ctz(changed);
+        changed &= changed - 1;
+        input_process_gamepad_button(index, (gamepad_buttons)button, (gamepad->buttons >> button) & 1);
+    }
+    kcopy_memory(current->axes, gamepad->axes, sizeof(current->axes));
+}
+
+void input_process_gamepad_connection(u32 index, b8 connected) {
+    if (index >= INPUT_MAX_GAMEPADS) {
+        return;
+    }
+    gamepad_state* current = &state.gamepads_current[index];
+    if (current->connected == connected) {
+        return;
+    }
+    // Release anything held, so listeners see a matching release for every press.
+    while (current->buttons) {
+        input_process_gamepad_button(index, (gamepad_buttons)__builtin_ctz(current->buttons), FALSE);
+    }
+    kzero_memory(current->axes, sizeof(current->axes));
+    current->connected = connected;
+
+    event_context context = {};
+    context.data.u16[0] = (u16)index;
+    context.data.u8[2] = connected;
+    event_post(EVENT_CODE_GAMEPAD_CONNECTION, 0, context);
+}
+
+void input_process_gamepad_button(u32 index, gamepad_buttons button, b8 pressed) {
+    if (index >= INPUT_MAX_GAMEPADS || button >= GAMEPAD_BUTTON_MAX_BUTTONS) {
+        return;
+    }
+    gamepad_state* current = &state.gamepads_current[index];
+    u32 bit = 1u << button;
+    if (((current->buttons & bit) != 0) == (pressed != 0)) {
+        return;
+    }
+    current->buttons ^= bit;
+    latency_input_received();
+
+    event_context context = {};
+    context.data.u16[0] = button;
+    context.data.u16[1] = (u16)index;
+    event_post(pressed ? EVENT_CODE_GAMEPAD_BUTTON_PRESSED : EVENT_CODE_GAMEPAD_BUTTON_RELEASED, 0, context);
+}
+
+b8 input_is_gamepad_connected(u32 index) {
+    if (!initialized || index >= INPUT_MAX_GAMEPADS) {
+        return FALSE;
+    }
+    return state.gamepads_current[index].connected;
+}
+
+b8 input_is_gamepad_button_down(u32 index, gamepad_buttons button) {
+    if (!initialized || index >= INPUT_MAX_GAMEPADS) {
+        return FALSE;
+    }
+    return (state.gamepads_current[index].buttons >> button) & 1;
+}
+
+b8 input_was_gamepad_button_down(u32 index, gamepad_buttons button) {
+    if (!initialized || index >= INPUT_MAX_GAMEPADS) {
+        return FALSE;
+    }
+    return (state.gamepads_previous[index].buttons >> button) & 1;
+}
+
+f32 input_get_gamepad_axis(u32 index, gamepad_axes axis) {
+    if (!initialized || index >= INPUT_MAX_GAMEPADS || axis >= GAMEPAD_AXIS_MAX_AXES) {
+        return 0;
+    }
+    return state.gamepads_current[index].axes[axis];
+}
+
+const b8* input_get_key_states() {
+    return state.keyboard_current.keys;
+}
+
+const u8* input_get_button_states() {
+    return state.mouse_current.buttons;
+}
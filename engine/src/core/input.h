@@ -1,6 +1,7 @@
 #pragma once
 
 #include "defines.h"
+#include "core/gamepad.h"
 
 typedef enum buttons {
     BUTTON_LEFT,
@@ -142,6 +143,27 @@ typedef enum keys {
     KEYS_MAX_KEYS
 } keys;
 
+// A key transition, as delivered by the platform.
+typedef struct input_key_event {
+    keys key;
+    b8 pressed;
+    // The platform's timestamp of the transition, in milliseconds. Only meaningful relative
+    // to other input timestamps; wraps after about 49 days.
+    u32 timestamp;
+} input_key_event;
+
+// A mouse button transition, as delivered by the platform.
+typedef struct input_button_event {
+    buttons button;
+    b8 pressed;
+    // As input_key_event.timestamp.
+    u32 timestamp;
+} input_button_event;
+
+// The number of transitions of each kind kept per frame. Further ones still update the
+// input state but are left out of the buffer.
+#define INPUT_EVENT_BUFFER_CAPACITY 256
+
 void input_initialize();
 void input_shutdown();
 void input_update(f64 delta_time);
@@ -152,7 +174,19 @@ VAPI b8 input_is_key_up(keys key);
 VAPI b8 input_was_key_down(keys key);
 VAPI b8 input_was_key_up(keys key);
 
-void input_process_key(keys key, b8 pressed);
+/**
+ * Obtains every key transition delivered since the last input_update, in the order they
+ * happened. Unlike comparing current and previous state, this sees each press and release
+ * of a key that changed more than once in a frame.
+ * @param out_events Receives a pointer to the transitions, valid until the next input_update.
+ * @returns The number of transitions.
+ */
+VAPI u32 input_get_key_events(const input_key_event** out_events);
+
+// Returns the number of times the key was pressed since the last input_update.
+VAPI u32 input_get_key_press_count(keys key);
+
+void input_process_key(keys key, b8 pressed, u32 timestamp);
 
 // mouse input
 VAPI b8 input_is_button_down(buttons button);
@@ -162,6 +196,46 @@ VAPI b8 input_was_button_up(buttons button);
 VAPI void input_get_mouse_position(i32* x, i32* y);
 VAPI void input_get_previous_mouse_position(i32* x, i32* y);
 
-void input_process_button(buttons button, b8 pressed);
+/**
+ * Obtains the relative mouse motion reported since the last input_update, unaccelerated
+ * and with sub-pixel precision. Unlike the difference between mouse positions, this is
+ * not clamped to the window and does not lose motion the server coalesces. Only
+ * available where the platform reports raw motion; see input_has_raw_mouse_motion.
+ * @param dx Receives the horizontal motion, in device units.
+ * @param dy Receives the vertical motion, in device units.
+ */
+VAPI void input_get_mouse_raw_delta(f32* dx, f32* dy);
+
+// Returns TRUE if the platform reports raw mouse motion.
+VAPI b8 input_has_raw_mouse_motion();
+
+/**
+ * Obtains every mouse button transition delivered since the last input_update, in order.
+ * @param out_events Receives a pointer to the transitions, valid until the next input_update.
+ * @returns The number of transitions.
+ */
+VAPI u32 input_get_button_events(const input_button_event** out_events);
+
+void input_process_button(buttons button, b8 pressed, u32 timestamp);
+
+// gamepad input
+VAPI b8 input_is_gamepad_connected(u32 index);
+VAPI b8 input_is_gamepad_button_down(u32 index, gamepad_buttons button);
+VAPI b8 input_was_gamepad_button_down(u32 index, gamepad_buttons button);
+// Returns the value of the axis; see gamepad_axes for ranges. 0 if the gamepad is not connected.
+VAPI f32 input_get_gamepad_axis(u32 index, gamepad_axes axis);
+
+// Updates a gamepad from the platform's latest snapshot, posting events for what changed.
+void input_process_gamepad(u32 index, const gamepad_state* gamepad);
+void input_process_gamepad_connection(u32 index, b8 connected);
+void input_process_gamepad_button(u32 index, gamepad_buttons button, b8 pressed);
+
+// The current state of every key, indexed by keys, for bulk reads by the action layer.
+const b8* input_get_key_states();
+// The current state of every mouse button, indexed by buttons.
+const u8* input_get_button_states();
 void input_process_mouse_move(i16 x, i16 y);
 void input_process_mouse_wheel(i8 z_delta);
+void input_process_mouse_raw_motion(f32 dx, f32 dy);
+// Called by the platform layer once raw mouse motion is known to be available.
+void input_set_raw_mouse_motion_available(b8 available);
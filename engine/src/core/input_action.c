@@ -0,0 +1,431 @@
+#include "core/input_action.h"
+
+#include "core/logger.h"
+#include "core/mem.h"
+#include "core/str.h"
+#include "containers/darray.h"
+
+typedef struct action_record {
+    string_id name;
+    // Number of this action's bindings currently satisfied.
+    u16 satisfied_count;
+    u16 press_count;
+    b8 down;
+    b8 pressed;
+    b8 released;
+} action_record;
+
+typedef struct axis_record {
+    string_id name;
+    f32 value;
+} axis_record;
+
+typedef struct input_binding {
+    // The index of the bound action or axis.
+    u16 target;
+    b8 is_axis;
+    u8 input_count;
+    // Number of the inputs currently down. The binding is satisfied when this equals input_count.
+    u8 down_count;
+    input_binding_code inputs[INPUT_CHORD_MAX_INPUTS];
+    f32 scale;
+} input_binding;
+
+typedef struct input_action_system_state {
+    // darrays, indexed by id.
+    action_record* actions;
+    axis_record* axes;
+    // darray of every binding, packed.
+    input_binding* bindings;
+    // Index from input to the bindings that use it: the bindings using input i are
+    // binding_index[binding_index_offsets[i] .. binding_index_offsets[i + 1]).
+    u32 binding_index_offsets[INPUT_BINDING_CODE_COUNT + 1];
+    u16* binding_index;
+    u32 binding_index_capacity;
+    // Set when bindings change; the index is rebuilt at the next update.
+    b8 bindings_dirty;
+    // The state of every input as of the last update.
+    b8 input_down[INPUT_BINDING_CODE_COUNT];
+} input_action_system_state;
+
+static b8 initialized = FALSE;
+static input_action_system_state state;
+
+static inline b8 binding_satisfied(const input_binding* b) {
+    return b->down_count == b->input_count;
+}
+
+void input_action_system_initialize() {
+    kzero_memory(&state, sizeof(state));
+    state.actions = darray_create(action_record);
+    state.axes = darray_create(axis_record);
+    state.bindings = darray_create(input_binding);
+    initialized = TRUE;
+}
+
+void input_action_system_shutdown() {
+    if (!initialized) {
+        return;
+    }
+    darray_destroy(state.actions);
+    darray_destroy(state.axes);
+    darray_destroy(state.bindings);
+    if (state.binding_index) {
+        kfree(state.binding_index, sizeof(u16) * state.binding_index_capacity, MEMORY_TAG_ARRAY);
+    }
+    kzero_memory(&state, sizeof(state));
+    initialized = FALSE;
+}
+
+static input_action_id action_find_by_name(string_id name) {
+    u64 count = darray_length(state.actions);
+    for (u64 i = 0; i < count; ++i) {
+        if (state.actions[i].name == name) {
+            return (input_action_id)i;
+        }
+    }
+    return INVALID_INPUT_ACTION;
+}
+
+static input_action_id axis_find_by_name(string_id name) {
+    u64 count = darray_length(state.axes);
+    for (u64 i = 0; i < count; ++i) {
+        if (state.axes[i].name == name) {
+            return (input_action_id)i;
+        }
+    }
+    return INVALID_INPUT_ACTION;
+}
+
+input_action_id input_action_create(const char* name) {
+    string_id id = string_intern(name);
+    if (!initialized || id == INVALID_STRING_ID) {
+        return INVALID_INPUT_ACTION;
+    }
+    input_action_id existing = action_find_by_name(id);
+    if (existing != INVALID_INPUT_ACTION) {
+        return existing;
+    }
+    if (axis_find_by_name(id) != INVALID_INPUT_ACTION) {
+        verror("input_action_create: '%s' is already an axis.", name);
+        return INVALID_INPUT_ACTION;
+    }
+    if (darray_length(state.actions) >= INVALID_INPUT_ACTION) {
+        verror("input_action_create: too many actions.");
+        return INVALID_INPUT_ACTION;
+    }
+
+    action_record record = {};
+    record.name = id;
+    darray_push(state.actions, record);
+    return (input_action_id)(darray_length(state.actions) - 1);
+}
+
+input_action_id input_axis_create(const char* name) {
+    string_id id = string_intern(name);
+    if (!initialized || id == INVALID_STRING_ID) {
+        return INVALID_INPUT_ACTION;
+    }
+    input_action_id existing = axis_find_by_name(id);
+    if (existing != INVALID_INPUT_ACTION) {
+        return existing;
+    }
+    if (action_find_by_name(id) != INVALID_INPUT_ACTION) {
+        verror("input_axis_create: '%s' is already an action.", name);
+        return INVALID_INPUT_ACTION;
+    }
+    if (darray_length(state.axes) >= INVALID_INPUT_ACTION) {
+        verror("input_axis_create: too many axes.");
+        return INVALID_INPUT_ACTION;
+    }
+
+    axis_record record = {};
+    record.name = id;
+    darray_push(state.axes, record);
+    return (input_action_id)(darray_length(state.axes) - 1);
+}
+
+input_action_id input_action_find(const char* name) {
+    string_id id = string_intern_find(name);
+    if (!initialized || id == INVALID_STRING_ID) {
+        return INVALID_INPUT_ACTION;
+    }
+    return action_find_by_name(id);
+}
+
+input_action_id input_axis_find(const char* name) {
+    string_id id = string_intern_find(name);
+    if (!initialized || id == INVALID_STRING_ID) {
+        return INVALID_INPUT_ACTION;
+    }
+    return axis_find_by_name(id);
+}
+
+static b8 binding_add(u16 target, b8 is_axis, const input_binding_code* inputs, u32 input_count, f32 scale) {
+    if (input_count == 0 || input_count > INPUT_CHORD_MAX_INPUTS) {
+        verror("Input bindings need between 1 and %u inputs.", INPUT_CHORD_MAX_INPUTS);
+        return FALSE;
+    }
+    if (darray_length(state.bindings) >= 0xFFFF) {
+        verror("Too many input bindings.");
+        return FALSE;
+    }
+
+    input_binding binding = {};
+    binding.target = target;
+    binding.is_axis = is_axis;
+    binding.input_count = (u8)input_count;
+    binding.scale = scale;
+    for (u32 i = 0; i < input_count; ++i) {
+        if (inputs[i] >= INPUT_BINDING_CODE_COUNT) {
+            verror("Invalid input binding code %hu.", inputs[i]);
+            return FALSE;
+        }
+        for (u32 j = 0; j < i; ++j) {
+            if (inputs[j] == inputs[i]) {
+                verror("Input binding code %hu appears twice in one chord.", inputs[i]);
+                return FALSE;
+            }
+        }
+        binding.inputs[i] = inputs[i];
+    }
+
+    darray_push(state.bindings, binding);
+    state.bindings_dirty = TRUE;
+    return TRUE;
+}
+
+b8 input_action_bind(input_action_id action, const input_binding_code* inputs, u32 input_count) {
+    if (!initialized || action >= darray_length(state.actions)) {
+        return FALSE;
+    }
+    return binding_add(action, FALSE, inputs, input_count, 0);
+}
+
+b8 input_action_bind_key(input_action_id action, keys key) {
+    input_binding_code code = INPUT_BINDING_KEY_CODE(key);
+    return input_action_bind(action, &code, 1);
+}
+
+b8 input_action_bind_button(input_action_id action, buttons button) {
+    input_binding_code code = INPUT_BINDING_BUTTON_CODE(button);
+    return input_action_bind(action, &code, 1);
+}
+
+b8 input_axis_bind(input_action_id axis, const input_binding_code* inputs, u32 input_count, f32 scale) {
+    if (!initialized || axis >= darray_length(state.axes)) {
+        return FALSE;
+    }
+    return binding_add(axis, TRUE, inputs, input_count, scale);
+}
+
+b8 input_axis_bind_key(input_action_id axis, keys key, f32 scale) {
+    input_binding_code code = INPUT_BINDING_KEY_CODE(key);
+    return input_axis_bind(axis, &code, 1, scale);
+}
+
+static void bindings_remove(u16 target, b8 is_axis) {
+    u64 count = darray_length(state.bindings);
+    u64 kept = 0;
+    for (u64 i = 0; i < count; ++i) {
+        if (state.bindings[i].target != target || state.bindings[i].is_axis != is_axis) {
+            state.bindings[kept++] = state.bindings[i];
+        }
+    }
+    darray_length_set(state.bindings, kept);
+    state.bindings_dirty = TRUE;
+}
+
+void input_action_unbind_all(input_action_id action) {
+    if (initialized && action < darray_length(state.actions)) {
+        bindings_remove(action, FALSE);
+    }
+}
+
+void input_axis_unbind_all(input_action_id axis) {
+    if (initialized && axis < darray_length(state.axes)) {
+        bindings_remove(axis, TRUE);
+    }
+}
+
+// Rebuilds the index from inputs to bindings, and each binding's and action's state from
+// the inputs currently down. No presses or releases are reported for the change.
+static void bindings_rebuild() {
+    u32 binding_count = (u32)darray_length(state.bindings);
+
+    // Count the uses of each input, then turn the counts into offsets.
+    kzero_memory(state.binding_index_offsets, sizeof(state.binding_index_offsets));
+    for (u32 i = 0; i < binding_count; ++i) {
+        for (u32 j = 0; j < state.bindings[i].input_count; ++j) {
+            state.binding_index_offsets[state.bindings[i].inputs[j] + 1]++;
+        }
+    }
+    for (u32 i = 0; i < INPUT_BINDING_CODE_COUNT; ++i) {
+        state.binding_index_offsets[i + 1] += state.binding_index_offsets[i];
+    }
+
+    u32 total = state.binding_index_offsets[INPUT_BINDING_CODE_COUNT];
+    if (total > state.binding_index_capacity) {
+        if (state.binding_index) {
+            kfree(state.binding_index, sizeof(u16) * state.binding_index_capacity, MEMORY_TAG_ARRAY);
+        }
+        state.binding_index_capacity = total * 2;
+        state.binding_index = kallocate(sizeof(u16) * state.binding_index_capacity, MEMORY_TAG_ARRAY);
+    }
+
+    // Fill each input's range, using a copy of the offsets as write cursors.
+    u32 cursors[INPUT_BINDING_CODE_COUNT];
+    kcopy_memory(cursors, state.binding_index_offsets, sizeof(cursors));
+    u64 action_count = darray_length(state.actions);
+    for (u64 i = 0; i < action_count; ++i) {
+        state.actions[i].satisfied_count = 0;
+    }
+    for (u32 i = 0; i < binding_count; ++i) {
+        input_binding* b = &state.bindings[i];
+        b->down_count = 0;
+        for (u32 j = 0; j < b->input_count; ++j) {
+            state.binding_index[cursors[b->inputs[j]]++] = (u16)i;
+            if (state.input_down[b->inputs[j]]) {
+                b->down_count++;
+            }
+        }
+        if (!b->is_axis && binding_satisfied(b)) {
+            state.actions[b->target].satisfied_count++;
+        }
+    }
+    for (u64 i = 0; i < action_count; ++i) {
+        state.actions[i].down = state.actions[i].satisfied_count > 0;
+    }
+
+    state.bindings_dirty = FALSE;
+}
+
+// Applies one input transition to every binding that uses the input.
+static void input_apply(input_binding_code code, b8 down) {
+    if (state.input_down[code] == down) {
+        return;
+    }
+    state.input_down[code] = down;
+
+    u32 end = state.binding_index_offsets[code + 1];
+    for (u32 i = state.binding_index_offsets[code]; i < end; ++i) {
+        input_binding* b = &state.bindings[state.binding_index[i]];
+        b8 was_satisfied = binding_satisfied(b);
+        b->down_count += down ? 1 : -1;
+        if (b->is_axis || binding_satisfied(b) == was_satisfied) {
+            continue;
+        }
+
+        action_record* a = &state.actions[b->target];
+        if (down) {
+            if (a->satisfied_count++ == 0) {
+                a->pressed = TRUE;
+                a->press_count++;
+            }
+        } else if (--a->satisfied_count == 0) {
+            a->released = TRUE;
+        }
+    }
+}
+
+void input_action_system_update() {
+    if (!initialized) {
+        return;
+    }
+    if (state.bindings_dirty) {
+        bindings_rebuild();
+    }
+
+    u64 action_count = darray_length(state.actions);
+    for (u64 i = 0; i < action_count; ++i) {
+        state.actions[i].pressed = FALSE;
+        state.actions[i].released = FALSE;
+        state.actions[i].press_count = 0;
+    }
+
+    // Replay the frame's transitions in the order they happened, merging keys and buttons
+    // by timestamp.
+    const input_key_event* key_events;
+    const input_button_event* button_events;
+    u32 key_count = input_get_key_events(&key_events);
+    u32 button_count = input_get_button_events(&button_events);
+    u32 k = 0;
+    u32 b = 0;
+    while (k < key_count || b < button_count) {
+        if (b == button_count || (k < key_count && (i32)(key_events[k].timestamp - button_events[b].timestamp) <= 0)) {
+            input_apply(INPUT_BINDING_KEY_CODE(key_events[k].key), key_events[k].pressed);
+            k++;
+        } else {
+            input_apply(INPUT_BINDING_BUTTON_CODE(button_events[b].button), button_events[b].pressed);
+            b++;
+        }
+    }
+
+    // Catch up with anything the buffers missed, such as transitions past their capacity.
+    const b8* key_states = input_get_key_states();
+    for (u32 i = 0; i < INPUT_BINDING_BUTTON; ++i) {
+        input_apply((input_binding_code)i, key_states[i]);
+    }
+    const u8* button_states = input_get_button_states();
+    for (u32 i = 0; i < BUTTON_MAX_BUTTONS; ++i) {
+        input_apply(INPUT_BINDING_BUTTON_CODE(i), button_states[i]);
+    }
+
+    for (u64 i = 0; i < action_count; ++i) {
+        state.actions[i].down = state.actions[i].satisfied_count > 0;
+    }
+
+    // Axes are cheap to recompute outright.
+    u64 axis_count = darray_length(state.axes);
+    for (u64 i = 0; i < axis_count; ++i) {
+        state.axes[i].value = 0;
+    }
+    u64 binding_count = darray_length(state.bindings);
+    for (u64 i = 0; i < binding_count; ++i) {
+        const input_binding* binding = &state.bindings[i];
+        if (binding->is_axis && binding_satisfied(binding)) {
+            state.axes[binding->target].value += binding->scale;
+        }
+    }
+    for (u64 i = 0; i < axis_count; ++i) {
+        f32 v = state.axes[i].value;
+        state.axes[i].value = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+    }
+}
+
+// Queries index the tables directly. Ids come from the create functions, so they are only
+// checked in debug builds.
+#if defined(_DEBUG)
+#define INPUT_ACTION_CHECK(array, id, fallback)                   \
+    if (!initialized || (id) >= darray_length(array)) {           \
+        verror("Invalid input action/axis id %hu.", (u16)(id));   \
+        return fallback;                                          \
+    }
+#else
+#define INPUT_ACTION_CHECK(array, id, fallback)
+#endif
+
+b8 input_action_is_down(input_action_id action) {
+    INPUT_ACTION_CHECK(state.actions, action, FALSE);
+    return state.actions[action].down;
+}
+
+b8 input_action_was_pressed(input_action_id action) {
+    INPUT_ACTION_CHECK(state.actions, action, FALSE);
+    return state.actions[action].pressed;
+}
+
+b8 input_action_was_released(input_action_id action) {
+    INPUT_ACTION_CHECK(state.actions, action, FALSE);
+    return state.actions[action].released;
+}
+
+u32 input_action_press_count(input_action_id action) {
+    INPUT_ACTION_CHECK(state.actions, action, 0);
+    return state.actions[action].press_count;
+}
+
+f32 input_axis_value(input_action_id axis) {
+    INPUT_ACTION_CHECK(state.axes, axis, 0);
+    return state.axes[axis].value;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "defines.h"
+#include "core/input.h"
+
+/*
+Input action mapping. Gameplay code binds named actions (jump, save) and axes (move_x)
+to keys, mouse buttons and chords of them, then queries them by id instead of polling
+individual keys. Every action and axis is resolved once per frame, right after platform
+messages are pumped, so queries are plain table reads.
+
+Resolution walks the frame's buffered input transitions (see input_get_key_events) in
+order, so an action whose binding is pressed and released within a single frame still
+reports the press. A chord is satisfied while all of its inputs are down, and becomes
+pressed when the last of them goes down.
+*/
+
+// Identifies an action or an axis. Only valid for the kind of mapping it was created as.
+typedef u16 input_action_id;
+
+#define INVALID_INPUT_ACTION 0xFFFF
+
+// The maximum number of inputs in one chord.
+#define INPUT_CHORD_MAX_INPUTS 4
+
+// Identifies an input that can be bound: a key, or a mouse button offset by INPUT_BINDING_BUTTON.
+typedef u16 input_binding_code;
+
+#define INPUT_BINDING_BUTTON 256
+#define INPUT_BINDING_KEY_CODE(key) ((input_binding_code)(key))
+#define INPUT_BINDING_BUTTON_CODE(button) ((input_binding_code)(INPUT_BINDING_BUTTON + (button)))
+#define INPUT_BINDING_CODE_COUNT (INPUT_BINDING_BUTTON + BUTTON_MAX_BUTTONS)
+
+void input_action_system_initialize();
+void input_action_system_shutdown();
+
+// Resolves every action and axis from the current input state. Called by the application
+// once per frame, after posted events are dispatched.
+void input_action_system_update();
+
+/**
+ * Creates an action, or obtains the existing one with the given name.
+ * @param name The name of the action.
+ * @returns The action's id, or INVALID_INPUT_ACTION if the name is in use by an axis.
+ */
+VAPI input_action_id input_action_create(const char* name);
+
+/**
+ * Creates an axis, or obtains the existing one with the given name.
+ * @param name The name of the axis.
+ * @returns The axis' id, or INVALID_INPUT_ACTION if the name is in use by an action.
+ */
+VAPI input_action_id input_axis_create(const char* name);
+
+// Returns the id of the action with the given name, or INVALID_INPUT_ACTION if there is none.
+VAPI input_action_id input_action_find(const char* name);
+
+// Returns the id of the axis with the given name, or INVALID_INPUT_ACTION if there is none.
+VAPI input_action_id input_axis_find(const char* name);
+
+/**
+ * Binds an action to a chord of inputs. Takes effect at the next update.
+ * @param action The action to bind.
+ * @param inputs The inputs that must all be down, in the order they are usually pressed.
+ * @param input_count The number of inputs, from 1 to INPUT_CHORD_MAX_INPUTS.
+ * @returns TRUE if bound; otherwise FALSE.
+ */
+VAPI b8 input_action_bind(input_action_id action, const input_binding_code* inputs, u32 input_count);
+
+// Binds an action to a single key.
+VAPI b8 input_action_bind_key(input_action_id action, keys key);
+
+// Binds an action to a single mouse button.
+VAPI b8 input_action_bind_button(input_action_id action, buttons button);
+
+/**
+ * Binds an axis to a chord of inputs. While the chord is satisfied, its scale is added to
+ * the axis value, which is then clamped to [-1, 1]. Takes effect at the next update.
+ * @param axis The axis to bind.
+ * @param inputs The inputs that must all be down.
+ * @param input_count The number of inputs, from 1 to INPUT_CHORD_MAX_INPUTS.
+ * @param scale The contribution of the binding, e.g. -1 for a "left" key on a horizontal axis.
+ * @returns TRUE if bound; otherwise FALSE.
+ */
+VAPI b8 input_axis_bind(input_action_id axis, const input_binding_code* inputs, u32 input_count, f32 scale);
+
+// Binds an axis to a single key.
+VAPI b8 input_axis_bind_key(input_action_id axis, keys key, f32 scale);
+
+// Removes every binding of the given action.
+VAPI void input_action_unbind_all(input_action_id action);
+
+// Removes every binding of the given axis.
+VAPI void input_axis_unbind_all(input_action_id axis);
+
+// Returns TRUE if any binding of the action is satisfied.
+VAPI b8 input_action_is_down(input_action_id action);
+
+// Returns TRUE if the action became down this frame, even if it was released again.
+VAPI b8 input_action_was_pressed(input_action_id action);
+
+// Returns TRUE if the action stopped being down this frame, even if it was pressed again.
+VAPI b8 input_action_was_released(input_action_id action);
+
+// Returns the number of times the action became down this frame.
+VAPI u32 input_action_press_count(input_action_id action);
+
+// Returns the value of the axis, in [-1, 1].
+VAPI f32 input_axis_value(input_action_id axis);
@@ -0,0 +1,149 @@
+#include "core/latency.h"
+
+#include "core/clock.h"
+#include "core/logger.h"
+#include "core/mem.h"
+#include "containers/sort.h"
+
+// The number of frames that can be between beginning and presentation at once.
+#define LATENCY_FRAME_HISTORY 8
+
+typedef struct latency_frame {
+    u64 frame_id;
+    // Clock times in nanoseconds.
+    u64 input_time;
+    u64 submit_time;
+    // TRUE from the beginning of a frame with input until it is presented.
+    b8 active;
+} latency_frame;
+
+typedef struct latency_state {
+    // Time of the first input not yet attributed to a frame, or 0 if none.
+    u64 pending_input_time;
+    latency_frame frames[LATENCY_FRAME_HISTORY];
+    // Rolling windows of latencies in microseconds, filled in pairs.
+    u32 submit_samples[LATENCY_SAMPLE_WINDOW];
+    u32 present_samples[LATENCY_SAMPLE_WINDOW];
+    u32 sample_head;
+    u32 sample_count;
+    u32 report_interval;
+    u32 frames_since_report;
+} latency_state;
+
+static b8 initialized = FALSE;
+static latency_state state;
+
+void latency_initialize() {
+    kzero_memory(&state, sizeof(state));
+    initialized = TRUE;
+}
+
+void latency_shutdown() {
+    initialized = FALSE;
+}
+
+void latency_input_received() {
+    if (initialized && state.pending_input_time == 0) {
+        state.pending_input_time = clock_now_ns();
+    }
+}
+
+void latency_frame_begin(u64 frame_id) {
+    if (!initialized) {
+        return;
+    }
+
+    latency_frame* frame = &state.frames[frame_id % LATENCY_FRAME_HISTORY];
+    frame->frame_id = frame_id;
+    frame->input_time = state.pending_input_time;
+    frame->submit_time = 0;
+    frame->active = state.pending_input_time != 0;
+    state.pending_input_time = 0;
+
+    if (state.report_interval && ++state.frames_since_report >= state.report_interval) {
+        state.frames_since_report = 0;
+        latency_report();
+    }
+}
+
+static inline latency_frame* latency_frame_find(u64 frame_id) {
+    latency_frame* frame = &state.frames[frame_id % LATENCY_FRAME_HISTORY];
+    return (initialized && frame->active && frame->frame_id == frame_id) ? frame : 0;
+}
+
+static inline u32 latency_to_us(u64 start, u64 end) {
+    return end > start ? (u32)((end - start + 500) / 1000) : 0;
+}
+
+void latency_frame_submitted(u64 frame_id) {
+    latency_frame* frame = latency_frame_find(frame_id);
+    if (frame) {
+        frame->submit_time = clock_now_ns();
+    }
+}
+
+void latency_frame_presented(u64 frame_id) {
+    latency_frame* frame = latency_frame_find(frame_id);
+    if (!frame || frame->submit_time == 0) {
+        return;
+    }
+
+    u64 now = clock_now_ns();
+    state.submit_samples[state.sample_head] = latency_to_us(frame->input_time, frame->submit_time);
+    state.present_samples[state.sample_head] = latency_to_us(frame->input_time, now);
+    state.sample_head = (state.sample_head + 1) % LATENCY_SAMPLE_WINDOW;
+    if (state.sample_count < LATENCY_SAMPLE_WINDOW) {
+        state.sample_count++;
+    }
+    frame->active = FALSE;
+}
+
+// Sorts a copy of the samples and reads nearest-rank percentiles from it.
+static void latency_percentiles_compute(const u32* samples, u32 count, latency_percentiles* out) {
+    kzero_memory(out, sizeof(latency_percentiles));
+    if (count == 0) {
+        return;
+    }
+
+    u32 sorted[LATENCY_SAMPLE_WINDOW];
+    u32 scratch[LATENCY_SAMPLE_WINDOW];
+    kcopy_memory(sorted, samples, sizeof(u32) * count);
+    radix_sort_u32(sorted, 0, count, scratch, 0);
+
+    const f64 percentiles[3] = {0.50, 0.90, 0.99};
+    f64* outputs[3] = {&out->p50_ms, &out->p90_ms, &out->p99_ms};
+    for (u32 i = 0; i < 3; ++i) {
+        u32 rank = (u32)(percentiles[i] * count + 0.999999);
+        *outputs[i] = sorted[rank > 0 ? rank - 1 : 0] / 1000.0;
+    }
+    out->max_ms = sorted[count - 1] / 1000.0;
+}
+
+void latency_get_stats(latency_stats* out_stats) {
+    kzero_memory(out_stats, sizeof(latency_stats));
+    if (!initialized) {
+        return;
+    }
+    // The windows are unordered sets of samples, so the ring's wrap point does not matter.
+    out_stats->sample_count = state.sample_count;
+    latency_percentiles_compute(state.submit_samples, state.sample_count, &out_stats->input_to_submit);
+    latency_percentiles_compute(state.present_samples, state.sample_count, &out_stats->input_to_present);
+}
+
+void latency_set_report_interval(u32 interval_frames) {
+    state.report_interval = interval_frames;
+    state.frames_since_report = 0;
+}
+
+void latency_report() {
+    latency_stats stats;
+    latency_get_stats(&stats);
+    if (stats.sample_count == 0) {
+        vinfo("Input latency: no frames with input yet.");
+        return;
+    }
+    const latency_percentiles* s = &stats.input_to_submit;
+    const latency_percentiles* p = &stats.input_to_present;
+    vinfo("Input latency over %u frames (ms, p50/p90/p99/max): to submit %.2f/%.2f/%.2f/%.2f, to present %.2f/%.2f/%.2f/%.2f",
+          stats.sample_count, s->p50_ms, s->p90_ms, s->p99_ms, s->max_ms, p->p50_ms, p->p90_ms, p->p99_ms, p->max_ms);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+Input-to-photon latency tracking. The input system stamps the first input of each
+frame as it is pumped from the platform. The frame carries its id (the event system's
+frame number) through update and renderer_draw_frame to the backend, which reports
+when the frame's work was submitted to the GPU and when it was handed to the
+presentation engine. For every frame that had input, the time from the input to
+each of those points is kept in a rolling window, from which percentiles are reported.
+
+Presentation is timed when the present call returns, i.e. when the image is queued
+for display. The time it then spends in the presentation engine depends on the
+present mode and frames in flight, and is not included.
+*/
+
+// The number of frames with input over which percentiles are computed.
+#define LATENCY_SAMPLE_WINDOW 512
+
+typedef struct latency_percentiles {
+    f64 p50_ms;
+    f64 p90_ms;
+    f64 p99_ms;
+    f64 max_ms;
+} latency_percentiles;
+
+typedef struct latency_stats {
+    // The number of frames in the window.
+    u32 sample_count;
+    // From the first input of a frame to the submission of that frame's GPU work.
+    latency_percentiles input_to_submit;
+    // From the first input of a frame to that frame being queued for presentation.
+    latency_percentiles input_to_present;
+} latency_stats;
+
+void latency_initialize();
+void latency_shutdown();
+
+// Stamps an input as received now. Called by the input system for every input event.
+void latency_input_received();
+
+// Starts tracking a frame, attributing to it the inputs received since the previous
+// frame began. Called by the application after pumping and dispatching events.
+void latency_frame_begin(u64 frame_id);
+
+// Records that the frame's GPU work was submitted. Called by the renderer backend.
+void latency_frame_submitted(u64 frame_id);
+
+// Records that the frame was queued for presentation. Called by the renderer backend.
+void latency_frame_presented(u64 frame_id);
+
+// Computes latency percentiles over the most recent frames with input.
+VAPI void latency_get_stats(latency_stats* out_stats);
+
+/**
+ * Sets how often latency percentiles are logged.
+ * @param interval_frames Log every this many frames, or never if 0. The default is 0.
+ */
+VAPI void latency_set_report_interval(u32 interval_frames);
+
+// Logs the current latency percentiles.
+VAPI void latency_report();
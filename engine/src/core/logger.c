@@ -1,10 +1,8 @@
 #include "logger.h"
 #include "asserts.h"
+#include "core/str.h"
 #include "platform/platform.h"
 
-// TODO: temporary
-#include <stdio.h>
-#include <string.h>
 #include <stdarg.h>
 
 b8 initialize_logging() {
@@ -20,30 +18,31 @@ void log_output(log_level level, const char* message, ...) {
     const char* level_strings[6] = {"[FATAL]: ", "[ERROR]: ", "[WARN]:  ", "[INFO]:  ", "[DEBUG]: ", "[TRACE]: "};
     b8 is_error = level < LOG_LEVEL_WARN;
 
-    // Technically imposes a 32k character limit on a single log entry, but...
-    // DON'T DO THAT!
-    const i32 msg_length = 32000;
-    char out_message[msg_length];
-    memset(out_message, 0, sizeof(out_message));
+    // Most entries fit on the stack. Longer ones spill over to the heap, so there is
+    // no limit on the length of a single entry.
+    char buffer[2048];
+    string_builder builder;
+    string_builder_create_from_buffer(buffer, sizeof(buffer), 0, &builder);
+    string_builder_append(&builder, level_strings[level]);
 
-    // Format original message.
+    // Format the prefix, message and newline into the one buffer.
     // NOTE: Oddly enough, MS's headers override the GCC/Clang va_list type with a "typedef char* va_list" in some
     // cases, and as a result throws a strange error here. The workaround for now is to just use __builtin_va_list,
     // which is the type GCC/Clang's va_start expects.
     __builtin_va_list arg_ptr;
     va_start(arg_ptr, message);
-    vsnprintf(out_message, msg_length, message, arg_ptr);
+    string_builder_appendv(&builder, message, arg_ptr);
     va_end(arg_ptr);
-
-    char out_message2[msg_length];
-    sprintf(out_message2, "%s%s\n", level_strings[level], out_message);
+    string_builder_append_char(&builder, '\n');
 
     // Platform-specific output.
     if (is_error) {
-        platform_console_write_error(out_message2, level);
+        platform_console_write_error(builder.data, level);
     } else {
-        platform_console_write(out_message2, level);
+        platform_console_write(builder.data, level);
     }
+
+    string_builder_destroy(&builder);
 }
 
 void report_assertion_failure(const char* expression, const char* message, const char* file, i32 line) {
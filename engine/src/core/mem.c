@@ -4,10 +4,6 @@
 #include "core/str.h"
 #include "platform/platform.h"
 
-// TODO: Custom string lib
-#include <string.h>
-#include <stdio.h>
-
 struct memory_stats {
     u64 total_allocated;
     u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
@@ -84,29 +80,36 @@ char* get_memory_usage_str() {
     const u64 mib = 1024 * 1024;
     const u64 kib = 1024;
 
-    char buffer[8000] = "System memory use (tagged):\n";
-    u64 offset = strlen(buffer);
+    // Build on the stack, spilling to the heap only if the report outgrows it.
+    char buffer[1024];
+    string_builder builder;
+    string_builder_create_from_buffer(buffer, sizeof(buffer), 0, &builder);
+    string_builder_append(&builder, "System memory use (tagged):\n");
     for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
-        char unit[4] = "XiB";
-        float amount = 1.0f;
+        const char* unit = "XiB";
+        f64 amount = 1.0;
         if (stats.tagged_allocations[i] >= gib) {
-            unit[0] = 'G';
-            amount = stats.tagged_allocations[i] / (float)gib;
+            unit = "GiB";
+            amount = stats.tagged_allocations[i] / (f64)gib;
         } else if (stats.tagged_allocations[i] >= mib) {
-            unit[0] = 'M';
-            amount = stats.tagged_allocations[i] / (float)mib;
+            unit = "MiB";
+            amount = stats.tagged_allocations[i] / (f64)mib;
         } else if (stats.tagged_allocations[i] >= kib) {
-            unit[0] = 'K';
-            amount = stats.tagged_allocations[i] / (float)kib;
+            unit = "KiB";
+            amount = stats.tagged_allocations[i] / (f64)kib;
         } else {
-            unit[0] = 'B';
-            unit[1] = 0;
-            amount = (float)stats.tagged_allocations[i];
+            unit = "B";
+            amount = (f64)stats.tagged_allocations[i];
         }
 
-        i32 length = snprintf(buffer + offset, 8000, "  %s: %.2f%s\n", memory_tag_strings[i], amount, unit);
-        offset += length;
+        string_builder_append(&builder, "  ");
+        string_builder_append(&builder, memory_tag_strings[i]);
+        string_builder_append(&builder, ": ");
+        string_builder_append_f64(&builder, amount, 2);
+        string_builder_append(&builder, unit);
+        string_builder_append_char(&builder, '\n');
     }
-    char* out_string = string_duplicate(buffer);
+    char* out_string = string_builder_to_string(&builder);
+    string_builder_destroy(&builder);
     return out_string;
-}
\ No newline at end of file
+}
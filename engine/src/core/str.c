@@ -1,10 +1,186 @@
 #include "core/str.h"
 #include "core/mem.h"
+#include "core/logger.h"
+#include "core/arena.h"
+#include "core/hash.h"
+#include "core/cpu.h"
+
+#include "containers/darray.h"
 
 #include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+static inline char char_to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+// Scalar fallbacks.
+
+static u64 string_length_scalar(const char* str) {
+    const char* p = str;
+    while (*p) {
+        ++p;
+    }
+    return (u64)(p - str);
+}
+
+static const char* string_find_char_scalar(const char* str, char c) {
+    for (;; ++str) {
+        if (*str == c) {
+            return str;
+        }
+        if (!*str) {
+            return 0;
+        }
+    }
+}
+
+static b8 strings_equal_scalar(const char* str0, const char* str1) {
+    while (*str0 && *str0 == *str1) {
+        ++str0;
+        ++str1;
+    }
+    return *str0 == *str1;
+}
+
+static b8 strings_equali_scalar(const char* str0, const char* str1) {
+    while (*str0 && char_to_lower(*str0) == char_to_lower(*str1)) {
+        ++str0;
+        ++str1;
+    }
+    return char_to_lower(*str0) == char_to_lower(*str1);
+}
+
+static const char* string_find_scalar(const char* str, const char* substr) {
+    u64 substr_length = string_length_scalar(substr);
+    if (substr_length == 0) {
+        return str;
+    }
+    for (; *str; ++str) {
+        if (*str == substr[0] && strncmp(str, substr, substr_length) == 0) {
+            return str;
+        }
+    }
+    return 0;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STRING_SIMD_X86 1
+#include <immintrin.h>
+
+// SSE2 kernels.
+#define SIMD_SUFFIX _sse2
+#define SIMD_WIDTH 16
+#define SIMD_FULL_MASK 0xFFFFu
+#define SIMD_TARGET __attribute__((target("sse2")))
+#define simd_vec __m128i
+#define simd_zero() _mm_setzero_si128()
+#define simd_set1(c) _mm_set1_epi8((char)(c))
+#define simd_load(p) _mm_load_si128((const __m128i*)(p))
+#define simd_loadu(p) _mm_loadu_si128((const __m128i*)(p))
+#define simd_cmpeq(a, b) _mm_cmpeq_epi8(a, b)
+#define simd_cmpgt(a, b) _mm_cmpgt_epi8(a, b)
+#define simd_and(a, b) _mm_and_si128(a, b)
+#define simd_or(a, b) _mm_or_si128(a, b)
+#define simd_add8(a, b) _mm_add_epi8(a, b)
+#define simd_movemask(v) ((u32)_mm_movemask_epi8(v))
+#include "core/str_simd.inl"
+#undef SIMD_SUFFIX
+#undef SIMD_WIDTH
+#undef SIMD_FULL_MASK
+#undef SIMD_TARGET
+#undef simd_vec
+#undef simd_zero
+#undef simd_set1
+#undef simd_load
+#undef simd_loadu
+#undef simd_cmpeq
+#undef simd_cmpgt
+#undef simd_and
+#undef simd_or
+#undef simd_add8
+#undef simd_movemask
+
+// AVX2 kernels.
+#define SIMD_SUFFIX _avx2
+#define SIMD_WIDTH 32
+#define SIMD_FULL_MASK 0xFFFFFFFFu
+#define SIMD_TARGET __attribute__((target("avx2")))
+#define simd_vec __m256i
+#define simd_zero() _mm256_setzero_si256()
+#define simd_set1(c) _mm256_set1_epi8((char)(c))
+#define simd_load(p) _mm256_load_si256((const __m256i*)(p))
+#define simd_loadu(p) _mm256_loadu_si256((const __m256i*)(p))
+#define simd_cmpeq(a, b) _mm256_cmpeq_epi8(a, b)
+#define simd_cmpgt(a, b) _mm256_cmpgt_epi8(a, b)
+#define simd_and(a, b) _mm256_and_si256(a, b)
+#define simd_or(a, b) _mm256_or_si256(a, b)
+#define simd_add8(a, b) _mm256_add_epi8(a, b)
+#define simd_movemask(v) ((u32)_mm256_movemask_epi8(v))
+#include "core/str_simd.inl"
+#undef SIMD_SUFFIX
+#undef SIMD_WIDTH
+#undef SIMD_FULL_MASK
+#undef SIMD_TARGET
+#undef simd_vec
+#undef simd_zero
+#undef simd_set1
+#undef simd_load
+#undef simd_loadu
+#undef simd_cmpeq
+#undef simd_cmpgt
+#undef simd_and
+#undef simd_or
+#undef simd_add8
+#undef simd_movemask
+#endif
+
+typedef struct string_kernels {
+    u64 (*length)(const char* str);
+    const char* (*find_char)(const char* str, char c);
+    b8 (*equal)(const char* str0, const char* str1);
+    b8 (*equali)(const char* str0, const char* str1);
+    const char* (*find)(const char* str, const char* substr);
+} string_kernels;
+
+// SSE2 is part of the x86-64 baseline, so it is usable before string_initialize runs.
+#if STRING_SIMD_X86
+static string_kernels kernels = {
+    string_length_sse2, string_find_char_sse2, strings_equal_sse2, strings_equali_sse2, string_find_sse2};
+#else
+static string_kernels kernels = {
+    string_length_scalar, string_find_char_scalar, strings_equal_scalar, strings_equali_scalar, string_find_scalar};
+#endif
+
+void string_initialize() {
+    string_number_initialize();
+
+#if STRING_SIMD_X86
+    if (cpu_has_feature(CPU_FEATURE_AVX2)) {
+        kernels.length = string_length_avx2;
+        kernels.find_char = string_find_char_avx2;
+        kernels.equal = strings_equal_avx2;
+        kernels.equali = strings_equali_avx2;
+        kernels.find = string_find_avx2;
+        vdebug("String routines using AVX2.");
+        return;
+    }
+    if (cpu_has_feature(CPU_FEATURE_SSE2)) {
+        vdebug("String routines using SSE2.");
+        return;
+    }
+#endif
+    kernels.length = string_length_scalar;
+    kernels.find_char = string_find_char_scalar;
+    kernels.equal = strings_equal_scalar;
+    kernels.equali = strings_equali_scalar;
+    kernels.find = string_find_scalar;
+    vdebug("String routines using scalar fallbacks.");
+}
 
 u64 string_length(const char* str) {
-    return strlen(str);
+    return kernels.length(str);
 }
 
 char* string_duplicate(const char* str) {
@@ -16,5 +192,395 @@ char* string_duplicate(const char* str) {
 
 // Case-sensitive string comparison. True if the same, otherwise false.
 b8 strings_equal(const char* str0, const char* str1) {
-    return strcmp(str0, str1) == 0;
-}
\ No newline at end of file
+    // Interned strings share storage, so identical pointers short-circuit.
+    if (str0 == str1) {
+        return TRUE;
+    }
+    return kernels.equal(str0, str1);
+}
+
+b8 strings_equali(const char* str0, const char* str1) {
+    if (str0 == str1) {
+        return TRUE;
+    }
+    return kernels.equali(str0, str1);
+}
+
+const char* string_find_char(const char* str, char c) {
+    return kernels.find_char(str, c);
+}
+
+const char* string_find(const char* str, const char* substr) {
+    return kernels.find(str, substr);
+}
+
+// String interning
+
+// Size of each block of string storage. Strings larger than this get a block of their own.
+#define INTERN_BLOCK_SIZE (64 * 1024)
+#define INTERN_INITIAL_SLOT_COUNT 256
+
+typedef struct intern_block {
+    struct intern_block* next;
+    u64 size;
+    u64 used;
+    // String data follows the header.
+} intern_block;
+
+typedef struct interned_string {
+    const char* str;
+    u64 hash;
+    u64 length;
+} interned_string;
+
+typedef struct string_intern_state {
+    // darray, indexed by id. Element 0 is the reserved invalid id.
+    interned_string* strings;
+    // Open-addressed lookup table of ids. 0 marks an empty slot.
+    string_id* slots;
+    u32 slot_count;
+    // The block currently being filled. Older blocks are chained through next.
+    intern_block* blocks;
+} string_intern_state;
+
+static b8 intern_initialized = FALSE;
+static string_intern_state intern_state;
+
+static u64 intern_hash(const char* str, u64* out_length) {
+    *out_length = string_length(str);
+    return hash_bytes(str, *out_length, 0);
+}
+
+static i64 intern_find_slot(u64 hash, const char* str, u64 length) {
+    u32 mask = intern_state.slot_count - 1;
+    u32 slot = (u32)hash & mask;
+    while (intern_state.slots[slot] != INVALID_STRING_ID) {
+        interned_string* s = &intern_state.strings[intern_state.slots[slot]];
+        if (s->hash == hash && s->length == length && memcmp(s->str, str, length) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    // Return the empty slot as a negative index for insertion.
+    return -(i64)slot - 1;
+}
+
+static void intern_grow_slots() {
+    u32 old_count = intern_state.slot_count;
+    string_id* old_slots = intern_state.slots;
+
+    intern_state.slot_count = old_count * 2;
+    intern_state.slots = kallocate(sizeof(string_id) * intern_state.slot_count, MEMORY_TAG_DICT);
+
+    u32 mask = intern_state.slot_count - 1;
+    for (u32 i = 0; i < old_count; ++i) {
+        string_id id = old_slots[i];
+        if (id != INVALID_STRING_ID) {
+            u32 slot = (u32)intern_state.strings[id].hash & mask;
+            while (intern_state.slots[slot] != INVALID_STRING_ID) {
+                slot = (slot + 1) & mask;
+            }
+            intern_state.slots[slot] = id;
+        }
+    }
+
+    kfree(old_slots, sizeof(string_id) * old_count, MEMORY_TAG_DICT);
+}
+
+static char* intern_store(const char* str, u64 length) {
+    u64 needed = length + 1;
+    intern_block* block = intern_state.blocks;
+    if (!block || block->size - block->used < needed) {
+        u64 size = needed > INTERN_BLOCK_SIZE ? needed : INTERN_BLOCK_SIZE;
+        intern_block* new_block = kallocate(sizeof(intern_block) + size, MEMORY_TAG_STRING);
+        new_block->size = size;
+        new_block->used = 0;
+        new_block->next = block;
+        intern_state.blocks = new_block;
+        block = new_block;
+    }
+
+    char* dest = (char*)(block + 1) + block->used;
+    kcopy_memory(dest, str, length);
+    dest[length] = 0;
+    block->used += needed;
+    return dest;
+}
+
+b8 string_intern_initialize() {
+    if (intern_initialized) {
+        return FALSE;
+    }
+
+    kzero_memory(&intern_state, sizeof(intern_state));
+    intern_state.strings = darray_create(interned_string);
+    interned_string invalid = {};
+    darray_push(intern_state.strings, invalid);
+
+    intern_state.slot_count = INTERN_INITIAL_SLOT_COUNT;
+    intern_state.slots = kallocate(sizeof(string_id) * intern_state.slot_count, MEMORY_TAG_DICT);
+
+    intern_initialized = TRUE;
+    return TRUE;
+}
+
+void string_intern_shutdown() {
+    if (!intern_initialized) {
+        return;
+    }
+
+    intern_block* block = intern_state.blocks;
+    while (block) {
+        intern_block* next = block->next;
+        kfree(block, sizeof(intern_block) + block->size, MEMORY_TAG_STRING);
+        block = next;
+    }
+    kfree(intern_state.slots, sizeof(string_id) * intern_state.slot_count, MEMORY_TAG_DICT);
+    darray_destroy(intern_state.strings);
+    kzero_memory(&intern_state, sizeof(intern_state));
+
+    intern_initialized = FALSE;
+}
+
+string_id string_intern(const char* str) {
+    if (!intern_initialized || !str) {
+        return INVALID_STRING_ID;
+    }
+
+    u64 length;
+    u64 hash = intern_hash(str, &length);
+    i64 slot = intern_find_slot(hash, str, length);
+    if (slot >= 0) {
+        return intern_state.slots[slot];
+    }
+
+    // Not found, store a copy. Keep the table at most half full.
+    u64 id = darray_length(intern_state.strings);
+    if ((id + 1) * 2 > intern_state.slot_count) {
+        intern_grow_slots();
+        slot = intern_find_slot(hash, str, length);
+    }
+
+    interned_string entry;
+    entry.str = intern_store(str, length);
+    entry.hash = hash;
+    entry.length = length;
+    darray_push(intern_state.strings, entry);
+    intern_state.slots[-slot - 1] = (string_id)id;
+    return (string_id)id;
+}
+
+string_id string_intern_find(const char* str) {
+    if (!intern_initialized || !str) {
+        return INVALID_STRING_ID;
+    }
+
+    u64 length;
+    u64 hash = intern_hash(str, &length);
+    i64 slot = intern_find_slot(hash, str, length);
+    return slot >= 0 ? intern_state.slots[slot] : INVALID_STRING_ID;
+}
+
+const char* string_intern_get(string_id id) {
+    if (!intern_initialized || id == INVALID_STRING_ID || id >= darray_length(intern_state.strings)) {
+        return 0;
+    }
+    return intern_state.strings[id].str;
+}
+
+const char* string_intern_str(const char* str) {
+    return string_intern_get(string_intern(str));
+}
+
+// String builder
+
+#define STRING_BUILDER_MIN_CAPACITY 64
+
+static char* builder_allocate(string_builder* builder, u64 size) {
+    if (builder->arena) {
+        return arena_allocate(builder->arena, size, 1);
+    }
+    return kallocate(size, MEMORY_TAG_STRING);
+}
+
+static void builder_grow(string_builder* builder, u64 required) {
+    u64 new_capacity = builder->capacity ? builder->capacity : STRING_BUILDER_MIN_CAPACITY;
+    while (new_capacity < required) {
+        new_capacity *= 2;
+    }
+
+    // Arena-backed data that is still the arena's latest allocation can grow in place.
+    if (builder->arena_data &&
+        arena_try_resize(builder->arena, builder->data, builder->capacity, new_capacity)) {
+        builder->capacity = new_capacity;
+        return;
+    }
+
+    char* new_data = builder_allocate(builder, new_capacity);
+    if (builder->data) {
+        kcopy_memory(new_data, builder->data, builder->length + 1);
+    } else {
+        new_data[0] = 0;
+    }
+    if (builder->owns_data) {
+        kfree(builder->data, builder->capacity, MEMORY_TAG_STRING);
+    }
+    builder->data = new_data;
+    builder->capacity = new_capacity;
+    builder->owns_data = builder->arena == 0;
+    builder->arena_data = builder->arena != 0;
+}
+
+void string_builder_create(struct arena* arena, u64 initial_capacity, string_builder* out_builder) {
+    kzero_memory(out_builder, sizeof(string_builder));
+    out_builder->arena = arena;
+    builder_grow(out_builder, initial_capacity > 0 ? initial_capacity : STRING_BUILDER_MIN_CAPACITY);
+}
+
+void string_builder_create_from_buffer(char* buffer, u64 buffer_size, struct arena* arena, string_builder* out_builder) {
+    kzero_memory(out_builder, sizeof(string_builder));
+    out_builder->arena = arena;
+    out_builder->data = buffer;
+    out_builder->capacity = buffer_size;
+    buffer[0] = 0;
+}
+
+void string_builder_destroy(string_builder* builder) {
+    if (builder->owns_data) {
+        kfree(builder->data, builder->capacity, MEMORY_TAG_STRING);
+    }
+    kzero_memory(builder, sizeof(string_builder));
+}
+
+void string_builder_clear(string_builder* builder) {
+    builder->length = 0;
+    builder->data[0] = 0;
+}
+
+void string_builder_reserve(string_builder* builder, u64 additional) {
+    u64 required = builder->length + additional + 1;
+    if (required > builder->capacity) {
+        builder_grow(builder, required);
+    }
+}
+
+void string_builder_append_n(string_builder* builder, const char* str, u64 length) {
+    string_builder_reserve(builder, length);
+    kcopy_memory(builder->data + builder->length, str, length);
+    builder->length += length;
+    builder->data[builder->length] = 0;
+}
+
+void string_builder_append(string_builder* builder, const char* str) {
+    string_builder_append_n(builder, str, string_length(str));
+}
+
+void string_builder_append_char(string_builder* builder, char c) {
+    string_builder_reserve(builder, 1);
+    builder->data[builder->length++] = c;
+    builder->data[builder->length] = 0;
+}
+
+void string_builder_append_u64(string_builder* builder, u64 value) {
+    char buffer[STRING_NUMBER_BUFFER_SIZE];
+    u32 length = string_format_u64(value, buffer);
+    string_builder_append_n(builder, buffer, length);
+}
+
+void string_builder_append_i64(string_builder* builder, i64 value) {
+    if (value < 0) {
+        string_builder_append_char(builder, '-');
+        // Negate in unsigned space so that INT64_MIN is handled.
+        string_builder_append_u64(builder, 0 - (u64)value);
+    } else {
+        string_builder_append_u64(builder, (u64)value);
+    }
+}
+
+void string_builder_append_f64(string_builder* builder, f64 value, u32 decimals) {
+    // The integer path covers the common range. Very large values, non-finite values
+    // and high precision go through the C library instead.
+    if (decimals > 9) {
+        string_builder_appendf(builder, "%.*f", (i32)decimals, value);
+        return;
+    }
+
+    u64 scale = 1;
+    for (u32 i = 0; i < decimals; ++i) {
+        scale *= 10;
+    }
+
+    // The scaled value must fit in a u64. Keeping it below 2^52 also keeps the rounding
+    // below exact, as adding 0.5 is representable there.
+    const f64 limit = 4503599627370496.0 / (f64)scale;
+    if (!(value > -limit && value < limit)) {
+        string_builder_appendf(builder, "%.*f", (i32)decimals, value);
+        return;
+    }
+
+    b8 negative = value < 0;
+    f64 magnitude = negative ? -value : value;
+    u64 scaled = (u64)(magnitude * (f64)scale + 0.5);
+    u64 whole = scaled / scale;
+    u64 fraction = scaled % scale;
+
+    if (negative && scaled != 0) {
+        string_builder_append_char(builder, '-');
+    }
+    string_builder_append_u64(builder, whole);
+    if (decimals > 0) {
+        string_builder_reserve(builder, decimals + 1);
+        builder->data[builder->length] = '.';
+        for (u32 i = decimals; i > 0; --i) {
+            builder->data[builder->length + i] = (char)('0' + fraction % 10);
+            fraction /= 10;
+        }
+        builder->length += decimals + 1;
+        builder->data[builder->length] = 0;
+    }
+}
+
+void string_builder_append_f64_shortest(string_builder* builder, f64 value) {
+    char buffer[STRING_NUMBER_BUFFER_SIZE];
+    u32 length = string_format_f64(value, buffer);
+    string_builder_append_n(builder, buffer, length);
+}
+
+void string_builder_append_f32_shortest(string_builder* builder, f32 value) {
+    char buffer[STRING_NUMBER_BUFFER_SIZE];
+    u32 length = string_format_f32(value, buffer);
+    string_builder_append_n(builder, buffer, length);
+}
+
+void string_builder_appendv(string_builder* builder, const char* format, __builtin_va_list args) {
+    // Try to format straight into the remaining space; if it doesn't fit, the first
+    // pass reports the exact size needed and the second pass cannot fail.
+    __builtin_va_list args_copy;
+    va_copy(args_copy, args);
+    u64 available = builder->capacity - builder->length;
+    i32 written = vsnprintf(builder->data + builder->length, available, format, args);
+    if (written < 0) {
+        builder->data[builder->length] = 0;
+        va_end(args_copy);
+        return;
+    }
+    if ((u64)written >= available) {
+        string_builder_reserve(builder, (u64)written);
+        vsnprintf(builder->data + builder->length, builder->capacity - builder->length, format, args_copy);
+    }
+    va_end(args_copy);
+    builder->length += (u64)written;
+}
+
+void string_builder_appendf(string_builder* builder, const char* format, ...) {
+    __builtin_va_list args;
+    va_start(args, format);
+    string_builder_appendv(builder, format, args);
+    va_end(args);
+}
+
+char* string_builder_to_string(const string_builder* builder) {
+    char* copy = kallocate(builder->length + 1, MEMORY_TAG_STRING);
+    kcopy_memory(copy, builder->data, builder->length + 1);
+    return copy;
+}
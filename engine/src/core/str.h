@@ -2,6 +2,10 @@
 
 #include "defines.h"
 
+// Selects the fastest string routines supported by the CPU. Until this is called,
+// baseline implementations are used.
+void string_initialize();
+
 // Returns the length of the given string.
 VAPI u64 string_length(const char* str);
 
@@ -9,3 +13,185 @@ VAPI char* string_duplicate(const char* str);
 
 // Case-sensitive string comparison. True if the same, otherwise false.
 VAPI b8 strings_equal(const char* str0, const char* str1);
+
+// Case-insensitive (ASCII) string comparison. True if the same, otherwise false.
+VAPI b8 strings_equali(const char* str0, const char* str1);
+
+// Returns a pointer to the first occurrence of c in str, or 0 if not found.
+// Searching for 0 returns a pointer to the terminator.
+VAPI const char* string_find_char(const char* str, char c);
+
+// Returns a pointer to the first occurrence of substr in str, or 0 if not found.
+VAPI const char* string_find(const char* str, const char* substr);
+
+/*
+Locale-independent number formatting and parsing.
+
+Floats are formatted as the shortest decimal that parses back to the identical value
+(Ryu), laid out like JavaScript's Number.prototype.toString: plain notation for
+moderate exponents ("0.1", "1920", "0.000001"), scientific otherwise ("1e+21",
+"5e-324"). Non-finite values format as "nan", "inf" and "-inf".
+
+Parsing accepts an optional sign, digits with an optional fraction and an optional
+exponent, or inf/infinity/nan (case-insensitive). Leading whitespace is not skipped.
+Inputs with up to 19 significant digits and moderate exponents are converted exactly
+without calling into the C library; anything else falls back to strtod in the "C"
+locale. All results are correctly rounded.
+*/
+
+// A buffer of this size holds any number written by the string_format_* functions.
+#define STRING_NUMBER_BUFFER_SIZE 32
+
+// Prepares the locale used by the parsing fallback. Called by string_initialize.
+void string_number_initialize();
+
+/**
+ * Writes the decimal representation of a value, zero-terminated.
+ * @param value The value to format.
+ * @param out_buffer The buffer to write to. Must hold STRING_NUMBER_BUFFER_SIZE characters.
+ * @returns The number of characters written, excluding the terminator.
+ */
+VAPI u32 string_format_u64(u64 value, char* out_buffer);
+VAPI u32 string_format_i64(i64 value, char* out_buffer);
+VAPI u32 string_format_f64(f64 value, char* out_buffer);
+VAPI u32 string_format_f32(f32 value, char* out_buffer);
+
+/**
+ * Parses a number from the start of the given characters. The input does not need
+ * to be zero-terminated; parsing stops at the first character that can't continue
+ * the number.
+ * @param str The characters to parse.
+ * @param length The number of characters available.
+ * @param out_value Receives the parsed value. Unchanged on failure.
+ * @returns The number of characters consumed, or 0 if no number was found or an
+ * integer did not fit the type.
+ */
+VAPI u64 string_parse_u64(const char* str, u64 length, u64* out_value);
+VAPI u64 string_parse_i64(const char* str, u64 length, i64* out_value);
+VAPI u64 string_parse_f64(const char* str, u64 length, f64* out_value);
+VAPI u64 string_parse_f32(const char* str, u64 length, f32* out_value);
+
+/*
+String interning. Each distinct string is stored once in append-only storage owned
+by the interner and is identified by a stable u32 id. Interned ids (and pointers)
+compare equal if and only if the strings do, so names that are looked up often
+should be interned once and compared as integers afterwards.
+
+Id 0 is never handed out and represents an invalid/empty handle.
+*/
+
+// An interned string identifier. Compare with ==.
+typedef u32 string_id;
+
+#define INVALID_STRING_ID 0
+
+b8 string_intern_initialize();
+void string_intern_shutdown();
+
+/**
+ * Interns the given string, storing a copy if it has not been seen before.
+ * @param str The string to intern.
+ * @returns The id of the interned string, or INVALID_STRING_ID on failure.
+ */
+VAPI string_id string_intern(const char* str);
+
+/**
+ * Looks up the id of the given string without interning it.
+ * @param str The string to look up.
+ * @returns The id of the string if it was interned; otherwise INVALID_STRING_ID.
+ */
+VAPI string_id string_intern_find(const char* str);
+
+/**
+ * Obtains the deduplicated storage for the given id. The pointer remains valid until
+ * the interner is shut down.
+ * @param id The id of the interned string.
+ * @returns A pointer to the interned string, or 0 if the id is invalid.
+ */
+VAPI const char* string_intern_get(string_id id);
+
+/**
+ * Interns the given string and returns its deduplicated storage. Two results from this
+ * function are equal strings if and only if the pointers are equal.
+ * @param str The string to intern.
+ * @returns A pointer to the interned string, or 0 on failure.
+ */
+VAPI const char* string_intern_str(const char* str);
+
+/*
+String builder. Appends grow the buffer as needed, so there is no fixed cap on the
+resulting length. Storage comes from one of three places:
+ - an arena, in which case nothing needs to be freed and growth extends in place
+   when the builder owns the arena's most recent allocation;
+ - the general allocator (MEMORY_TAG_STRING) when no arena is provided;
+ - an optional caller-provided initial buffer (e.g. on the stack), which is used
+   until it overflows and then spills to the arena or allocator.
+The contents are always zero-terminated.
+*/
+
+struct arena;
+
+typedef struct string_builder {
+    char* data;
+    // Length excluding the terminator.
+    u64 length;
+    // Usable capacity including the terminator.
+    u64 capacity;
+    // Arena to allocate from. If 0, the general allocator is used.
+    struct arena* arena;
+    // TRUE if data was obtained from the general allocator and must be freed.
+    b8 owns_data;
+    // TRUE if data was obtained from the arena.
+    b8 arena_data;
+} string_builder;
+
+/**
+ * Creates a new string builder.
+ * @param arena The arena to allocate from. If 0/NULL, the general allocator is used.
+ * @param initial_capacity The initial capacity in bytes.
+ * @param out_builder A pointer to hold the created builder.
+ */
+VAPI void string_builder_create(struct arena* arena, u64 initial_capacity, string_builder* out_builder);
+
+/**
+ * Creates a new string builder that writes into the provided buffer until it overflows.
+ * @param buffer The initial buffer. Must remain valid for the life of the builder.
+ * @param buffer_size The size of the initial buffer in bytes. Must be > 0.
+ * @param arena The arena to spill into. If 0/NULL, the general allocator is used.
+ * @param out_builder A pointer to hold the created builder.
+ */
+VAPI void string_builder_create_from_buffer(char* buffer, u64 buffer_size, struct arena* arena, string_builder* out_builder);
+
+// Releases any memory owned by the builder. Arena-backed memory is left to the arena.
+VAPI void string_builder_destroy(string_builder* builder);
+
+// Empties the builder without releasing its memory.
+VAPI void string_builder_clear(string_builder* builder);
+
+// Ensures at least the given number of additional characters can be appended without growing.
+VAPI void string_builder_reserve(string_builder* builder, u64 additional);
+
+VAPI void string_builder_append(string_builder* builder, const char* str);
+VAPI void string_builder_append_n(string_builder* builder, const char* str, u64 length);
+VAPI void string_builder_append_char(string_builder* builder, char c);
+VAPI void string_builder_append_i64(string_builder* builder, i64 value);
+VAPI void string_builder_append_u64(string_builder* builder, u64 value);
+
+/**
+ * Appends the given value in fixed-point notation.
+ * @param builder A pointer to the builder.
+ * @param value The value to append.
+ * @param decimals The number of digits after the decimal point.
+ */
+VAPI void string_builder_append_f64(string_builder* builder, f64 value, u32 decimals);
+
+// Appends the shortest representation that parses back to the same value. See string_format_f64.
+VAPI void string_builder_append_f64_shortest(string_builder* builder, f64 value);
+VAPI void string_builder_append_f32_shortest(string_builder* builder, f32 value);
+
+// Appends printf-style formatted output.
+VAPI void string_builder_appendf(string_builder* builder, const char* format, ...);
+VAPI void string_builder_appendv(string_builder* builder, const char* format, __builtin_va_list args);
+
+// Returns a copy of the built string from the general allocator (MEMORY_TAG_STRING).
+VAPI char* string_builder_to_string(const string_builder* builder);
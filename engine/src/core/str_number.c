@@ -0,0 +1,673 @@
+// strtod_l/strtof_l are GNU extensions on glibc.
+#define _GNU_SOURCE
+
+#include "core/str.h"
+#include "core/mem.h"
+
+#include <stdlib.h>
+#include <locale.h>
+#if defined(KPLATFORM_APPLE)
+#include <xlocale.h>
+#endif
+
+#include "core/str_number_tables.inl"
+
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Integer formatting.
+
+// Writes the digits of value ending just before end and returns a pointer to the first.
+static inline char* write_digits_backwards(u64 value, char* end) {
+    char* p = end;
+    while (value >= 100) {
+        u32 pair = (u32)(value % 100) * 2;
+        value /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (value >= 10) {
+        u32 pair = (u32)value * 2;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    } else {
+        *--p = (char)('0' + value);
+    }
+    return p;
+}
+
+static inline u32 decimal_length(u64 value) {
+    u32 length = 1;
+    for (u64 threshold = 10; length < 20 && value >= threshold; threshold *= 10) {
+        ++length;
+    }
+    return length;
+}
+
+u32 string_format_u64(u64 value, char* out_buffer) {
+    u32 length = decimal_length(value);
+    write_digits_backwards(value, out_buffer + length);
+    out_buffer[length] = 0;
+    return length;
+}
+
+u32 string_format_i64(i64 value, char* out_buffer) {
+    if (value < 0) {
+        out_buffer[0] = '-';
+        // Negate in unsigned space so that INT64_MIN is handled.
+        return 1 + string_format_u64(0 - (u64)value, out_buffer + 1);
+    }
+    return string_format_u64((u64)value, out_buffer);
+}
+
+// Shortest round-trip float formatting.
+//
+// This is Ryu (Ulf Adams, "Ryu: fast float-to-string conversion", PLDI 2018): the
+// interval of decimals that round to the input is computed exactly with 128-bit
+// fixed-point multiplies by precomputed powers of 5, then digits are removed while
+// the interval still contains a unique shortest candidate. f32 runs through the same
+// core with its own mantissa and exponent; the double tables are more than precise
+// enough for the smaller mantissa.
+
+#define DOUBLE_MANTISSA_BITS 52
+#define DOUBLE_EXPONENT_BITS 11
+#define DOUBLE_EXPONENT_BIAS 1023
+
+#define FLOAT_MANTISSA_BITS 23
+#define FLOAT_EXPONENT_BITS 8
+#define FLOAT_EXPONENT_BIAS 127
+
+typedef struct decimal_value {
+    u64 mantissa;
+    i32 exponent;
+} decimal_value;
+
+// floor(e * log10(2)), valid for 0 <= e <= 1650.
+static inline u32 log10_pow2(i32 e) {
+    return ((u32)e * 78913) >> 18;
+}
+
+// floor(e * log10(5)), valid for 0 <= e <= 2620.
+static inline u32 log10_pow5(i32 e) {
+    return ((u32)e * 732923) >> 20;
+}
+
+// ceil(log2(5^e)), or 1 if e == 0. Valid for 0 <= e <= 3528.
+static inline i32 pow5_bits(i32 e) {
+    return (i32)((((u32)e) * 1217359) >> 19) + 1;
+}
+
+static inline u32 pow5_factor(u64 value) {
+    u32 count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        ++count;
+    }
+    return count;
+}
+
+static inline b8 multiple_of_pow5(u64 value, u32 p) {
+    return pow5_factor(value) >= p;
+}
+
+static inline b8 multiple_of_pow2(u64 value, u32 p) {
+    return p < 64 && (value & ((1ull << p) - 1)) == 0;
+}
+
+// (m * mul) >> j, where mul is a 128-bit multiplier and j >= 64.
+static inline u64 mul_shift(u64 m, const u64* mul, i32 j) {
+    __uint128_t low = (__uint128_t)m * mul[0];
+    __uint128_t high = (__uint128_t)m * mul[1];
+    return (u64)(((low >> 64) + high) >> (j - 64));
+}
+
+// Converts a binary float m2 * 2^e2 to the shortest decimal that rounds back to it.
+// mm_shift is 1 unless the lower neighbour is closer (mantissa 0, above the smallest
+// normal exponent).
+static decimal_value shortest_decimal(u64 m2, i32 e2, u32 mm_shift) {
+    const b8 accept_bounds = (m2 & 1) == 0;
+    const u64 mv = 4 * m2;
+
+    u64 vr, vp, vm;
+    i32 e10;
+    b8 vm_trailing_zeros = FALSE;
+    b8 vr_trailing_zeros = FALSE;
+    if (e2 >= 0) {
+        const u32 q = log10_pow2(e2) - (e2 > 3);
+        e10 = (i32)q;
+        const i32 k = DOUBLE_POW5_INV_BITCOUNT + pow5_bits((i32)q) - 1;
+        const i32 j = -e2 + (i32)q + k;
+        vr = mul_shift(4 * m2, DOUBLE_POW5_INV_SPLIT[q], j);
+        vp = mul_shift(4 * m2 + 2, DOUBLE_POW5_INV_SPLIT[q], j);
+        vm = mul_shift(4 * m2 - 1 - mm_shift, DOUBLE_POW5_INV_SPLIT[q], j);
+        if (q <= 21) {
+            // At most one of mp, mv and mm can be a multiple of 5.
+            if (mv % 5 == 0) {
+                vr_trailing_zeros = multiple_of_pow5(mv, q);
+            } else if (accept_bounds) {
+                vm_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+            } else {
+                vp -= multiple_of_pow5(mv + 2, q);
+            }
+        }
+    } else {
+        const u32 q = log10_pow5(-e2) - (-e2 > 1);
+        e10 = (i32)q + e2;
+        const i32 i = -e2 - (i32)q;
+        const i32 k = pow5_bits(i) - DOUBLE_POW5_BITCOUNT;
+        const i32 j = (i32)q - k;
+        vr = mul_shift(4 * m2, DOUBLE_POW5_SPLIT[i], j);
+        vp = mul_shift(4 * m2 + 2, DOUBLE_POW5_SPLIT[i], j);
+        vm = mul_shift(4 * m2 - 1 - mm_shift, DOUBLE_POW5_SPLIT[i], j);
+        if (q <= 1) {
+            // mv has at least q trailing zero bits, so vr is exact.
+            vr_trailing_zeros = TRUE;
+            if (accept_bounds) {
+                vm_trailing_zeros = mm_shift == 1;
+            } else {
+                --vp;
+            }
+        } else if (q < 63) {
+            vr_trailing_zeros = multiple_of_pow2(mv, q);
+        }
+    }
+
+    // Remove digits while the interval [vm, vp] still contains a shorter candidate.
+    i32 removed = 0;
+    u32 last_removed_digit = 0;
+    u64 output;
+    if (vm_trailing_zeros || vr_trailing_zeros) {
+        // Rare: an exact bound or exact value means ties need careful rounding.
+        for (;;) {
+            const u64 vp_div10 = vp / 10;
+            const u64 vm_div10 = vm / 10;
+            if (vp_div10 <= vm_div10) {
+                break;
+            }
+            const u32 vm_mod10 = (u32)(vm - 10 * vm_div10);
+            const u64 vr_div10 = vr / 10;
+            const u32 vr_mod10 = (u32)(vr - 10 * vr_div10);
+            vm_trailing_zeros &= vm_mod10 == 0;
+            vr_trailing_zeros &= last_removed_digit == 0;
+            last_removed_digit = vr_mod10;
+            vr = vr_div10;
+            vp = vp_div10;
+            vm = vm_div10;
+            ++removed;
+        }
+        if (vm_trailing_zeros) {
+            for (;;) {
+                const u64 vm_div10 = vm / 10;
+                const u32 vm_mod10 = (u32)(vm - 10 * vm_div10);
+                if (vm_mod10 != 0) {
+                    break;
+                }
+                const u64 vr_div10 = vr / 10;
+                const u32 vr_mod10 = (u32)(vr - 10 * vr_div10);
+                vr_trailing_zeros &= last_removed_digit == 0;
+                last_removed_digit = vr_mod10;
+                vr = vr_div10;
+                vp = vp / 10;
+                vm = vm_div10;
+                ++removed;
+            }
+        }
+        if (vr_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0) {
+            // Exactly halfway: round to even.
+            last_removed_digit = 4;
+        }
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed_digit >= 5);
+    } else {
+        // Common case: no ties are possible, so only the last removed digit matters.
+        b8 round_up = FALSE;
+        const u64 vp_div100 = vp / 100;
+        const u64 vm_div100 = vm / 100;
+        if (vp_div100 > vm_div100) {
+            const u64 vr_div100 = vr / 100;
+            round_up = vr - 100 * vr_div100 >= 50;
+            vr = vr_div100;
+            vp = vp_div100;
+            vm = vm_div100;
+            removed += 2;
+        }
+        for (;;) {
+            const u64 vp_div10 = vp / 10;
+            const u64 vm_div10 = vm / 10;
+            if (vp_div10 <= vm_div10) {
+                break;
+            }
+            const u64 vr_div10 = vr / 10;
+            round_up = vr - 10 * vr_div10 >= 5;
+            vr = vr_div10;
+            vp = vp_div10;
+            vm = vm_div10;
+            ++removed;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+
+    decimal_value result = {output, e10 + removed};
+    return result;
+}
+
+// Integers in [1, 2^mantissa_bits) are exact; emit them directly without trailing zeros.
+static inline b8 small_integer_decimal(u64 m2, i32 e2, u32 mantissa_bits, decimal_value* out) {
+    if (e2 > 0 || e2 < -(i32)mantissa_bits) {
+        return FALSE;
+    }
+    const u64 fraction_mask = (1ull << -e2) - 1;
+    if ((m2 & fraction_mask) != 0) {
+        return FALSE;
+    }
+    out->mantissa = m2 >> -e2;
+    out->exponent = 0;
+    while (out->mantissa % 10 == 0) {
+        out->mantissa /= 10;
+        ++out->exponent;
+    }
+    return TRUE;
+}
+
+// Lays out mantissa * 10^exponent the way JavaScript's Number.prototype.toString does:
+// plain notation for decimal exponents in [-7, 21), scientific otherwise.
+static u32 write_decimal(b8 negative, decimal_value v, char* out) {
+    char* p = out;
+    if (negative) {
+        *p++ = '-';
+    }
+
+    char digits[20];
+    char* digits_end = digits + sizeof(digits);
+    const char* first = write_digits_backwards(v.mantissa, digits_end);
+    const i32 length = (i32)(digits_end - first);
+    // Position of the decimal point relative to the first digit.
+    const i32 point = length + v.exponent;
+
+    if (length <= point && point <= 21) {
+        kcopy_memory(p, first, (u64)length);
+        p += length;
+        for (i32 i = length; i < point; ++i) {
+            *p++ = '0';
+        }
+    } else if (0 < point && point <= 21) {
+        kcopy_memory(p, first, (u64)point);
+        p += point;
+        *p++ = '.';
+        kcopy_memory(p, first + point, (u64)(length - point));
+        p += length - point;
+    } else if (-6 < point && point <= 0) {
+        *p++ = '0';
+        *p++ = '.';
+        for (i32 i = point; i < 0; ++i) {
+            *p++ = '0';
+        }
+        kcopy_memory(p, first, (u64)length);
+        p += length;
+    } else {
+        *p++ = first[0];
+        if (length > 1) {
+            *p++ = '.';
+            kcopy_memory(p, first + 1, (u64)(length - 1));
+            p += length - 1;
+        }
+        i32 exponent = point - 1;
+        u32 magnitude = (u32)(exponent < 0 ? -exponent : exponent);
+        u32 exponent_length = decimal_length(magnitude);
+        *p++ = 'e';
+        *p++ = exponent < 0 ? '-' : '+';
+        write_digits_backwards(magnitude, p + exponent_length);
+        p += exponent_length;
+    }
+    *p = 0;
+    return (u32)(p - out);
+}
+
+static u32 write_special(b8 negative, b8 nan, char* out) {
+    const char* text = nan ? "nan" : (negative ? "-inf" : "inf");
+    u32 length = (u32)string_length(text);
+    kcopy_memory(out, text, length + 1);
+    return length;
+}
+
+u32 string_format_f64(f64 value, char* out_buffer) {
+    u64 bits;
+    kcopy_memory(&bits, &value, sizeof(bits));
+    const b8 negative = (bits >> 63) != 0;
+    const u64 mantissa = bits & ((1ull << DOUBLE_MANTISSA_BITS) - 1);
+    const u32 exponent = (u32)((bits >> DOUBLE_MANTISSA_BITS) & ((1u << DOUBLE_EXPONENT_BITS) - 1));
+
+    if (exponent == (1u << DOUBLE_EXPONENT_BITS) - 1) {
+        return write_special(negative, mantissa != 0, out_buffer);
+    }
+    if (exponent == 0 && mantissa == 0) {
+        decimal_value zero = {0, 0};
+        return write_decimal(negative, zero, out_buffer);
+    }
+
+    // The core works on m2 * 2^e2 with two extra bits of headroom for the bounds.
+    u64 m2;
+    i32 e2;
+    if (exponent == 0) {
+        m2 = mantissa;
+        e2 = 1 - DOUBLE_EXPONENT_BIAS - DOUBLE_MANTISSA_BITS;
+    } else {
+        m2 = (1ull << DOUBLE_MANTISSA_BITS) | mantissa;
+        e2 = (i32)exponent - DOUBLE_EXPONENT_BIAS - DOUBLE_MANTISSA_BITS;
+    }
+
+    decimal_value v;
+    if (!small_integer_decimal(m2, e2, DOUBLE_MANTISSA_BITS, &v)) {
+        v = shortest_decimal(m2, e2 - 2, mantissa != 0 || exponent <= 1);
+    }
+    return write_decimal(negative, v, out_buffer);
+}
+
+u32 string_format_f32(f32 value, char* out_buffer) {
+    u32 bits;
+    kcopy_memory(&bits, &value, sizeof(bits));
+    const b8 negative = (bits >> 31) != 0;
+    const u32 mantissa = bits & ((1u << FLOAT_MANTISSA_BITS) - 1);
+    const u32 exponent = (bits >> FLOAT_MANTISSA_BITS) & ((1u << FLOAT_EXPONENT_BITS) - 1);
+
+    if (exponent == (1u << FLOAT_EXPONENT_BITS) - 1) {
+        return write_special(negative, mantissa != 0, out_buffer);
+    }
+    if (exponent == 0 && mantissa == 0) {
+        decimal_value zero = {0, 0};
+        return write_decimal(negative, zero, out_buffer);
+    }
+
+    u64 m2;
+    i32 e2;
+    if (exponent == 0) {
+        m2 = mantissa;
+        e2 = 1 - FLOAT_EXPONENT_BIAS - FLOAT_MANTISSA_BITS;
+    } else {
+        m2 = (1ull << FLOAT_MANTISSA_BITS) | mantissa;
+        e2 = (i32)exponent - FLOAT_EXPONENT_BIAS - FLOAT_MANTISSA_BITS;
+    }
+
+    decimal_value v;
+    if (!small_integer_decimal(m2, e2, FLOAT_MANTISSA_BITS, &v)) {
+        v = shortest_decimal(m2, e2 - 2, mantissa != 0 || exponent <= 1);
+    }
+    return write_decimal(negative, v, out_buffer);
+}
+
+// Parsing.
+
+static inline b8 is_digit(char c) {
+    return (u8)(c - '0') < 10;
+}
+
+u64 string_parse_u64(const char* str, u64 length, u64* out_value) {
+    u64 i = 0;
+    if (i < length && str[i] == '+') {
+        ++i;
+    }
+    const u64 digits_start = i;
+    u64 value = 0;
+    for (; i < length && is_digit(str[i]); ++i) {
+        u64 digit = (u64)(str[i] - '0');
+        if (value > (~0ull - digit) / 10) {
+            return 0;
+        }
+        value = value * 10 + digit;
+    }
+    if (i == digits_start) {
+        return 0;
+    }
+    *out_value = value;
+    return i;
+}
+
+u64 string_parse_i64(const char* str, u64 length, i64* out_value) {
+    b8 negative = length > 0 && str[0] == '-';
+    u64 magnitude;
+    u64 consumed = string_parse_u64(str + negative, length - negative, &magnitude);
+    if (consumed == 0 || (negative && str[1] == '+')) {
+        return 0;
+    }
+    const u64 limit = negative ? (1ull << 63) : (1ull << 63) - 1;
+    if (magnitude > limit) {
+        return 0;
+    }
+    *out_value = negative ? (i64)(0 - magnitude) : (i64)magnitude;
+    return consumed + negative;
+}
+
+// A decimal number split into up to 19 significant digits and a power of ten.
+typedef struct decimal_parse {
+    u64 mantissa;
+    i64 exponent;
+    u64 length;
+    b8 negative;
+    // TRUE if significant digits were dropped, in which case mantissa is inexact.
+    b8 truncated;
+    // Set for "inf"/"infinity"/"nan", which are not described by mantissa/exponent.
+    b8 infinity;
+    b8 nan;
+} decimal_parse;
+
+static inline b8 matches_nocase(const char* str, u64 length, const char* word) {
+    u64 i = 0;
+    for (; word[i]; ++i) {
+        if (i >= length || (str[i] | 0x20) != word[i]) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// Scans [sign] (digits [. [digits]] | . digits) [(e|E) [sign] digits], or inf/infinity/nan.
+static b8 scan_decimal(const char* str, u64 length, decimal_parse* out) {
+    kzero_memory(out, sizeof(decimal_parse));
+    u64 i = 0;
+    if (i < length && (str[i] == '-' || str[i] == '+')) {
+        out->negative = str[i] == '-';
+        ++i;
+    }
+
+    if (i < length && !is_digit(str[i]) && str[i] != '.') {
+        if (matches_nocase(str + i, length - i, "infinity")) {
+            out->infinity = TRUE;
+            out->length = i + 8;
+            return TRUE;
+        }
+        if (matches_nocase(str + i, length - i, "inf")) {
+            out->infinity = TRUE;
+            out->length = i + 3;
+            return TRUE;
+        }
+        if (matches_nocase(str + i, length - i, "nan")) {
+            out->nan = TRUE;
+            out->length = i + 3;
+            return TRUE;
+        }
+        return FALSE;
+    }
+
+    u64 mantissa = 0;
+    u32 significant = 0;
+    i64 exponent = 0;
+    b8 any_digits = FALSE;
+    for (; i < length && is_digit(str[i]); ++i) {
+        any_digits = TRUE;
+        u32 digit = (u32)(str[i] - '0');
+        if (significant < 19) {
+            mantissa = mantissa * 10 + digit;
+            significant += mantissa != 0;
+        } else {
+            // Dropped integer digits still scale the value.
+            ++exponent;
+            out->truncated |= digit != 0;
+        }
+    }
+    if (i < length && str[i] == '.') {
+        ++i;
+        for (; i < length && is_digit(str[i]); ++i) {
+            any_digits = TRUE;
+            u32 digit = (u32)(str[i] - '0');
+            if (significant < 19) {
+                mantissa = mantissa * 10 + digit;
+                significant += mantissa != 0;
+                --exponent;
+            } else {
+                out->truncated |= digit != 0;
+            }
+        }
+    }
+    if (!any_digits) {
+        return FALSE;
+    }
+
+    // The exponent is optional; an 'e' that isn't followed by digits isn't part of the number.
+    if (i < length && (str[i] == 'e' || str[i] == 'E')) {
+        u64 j = i + 1;
+        b8 exponent_negative = FALSE;
+        if (j < length && (str[j] == '-' || str[j] == '+')) {
+            exponent_negative = str[j] == '-';
+            ++j;
+        }
+        if (j < length && is_digit(str[j])) {
+            i64 explicit_exponent = 0;
+            for (; j < length && is_digit(str[j]); ++j) {
+                // Saturate; anything this large is zero or infinity anyway.
+                if (explicit_exponent < 100000) {
+                    explicit_exponent = explicit_exponent * 10 + (str[j] - '0');
+                }
+            }
+            exponent += exponent_negative ? -explicit_exponent : explicit_exponent;
+            i = j;
+        }
+    }
+
+    out->mantissa = mantissa;
+    out->exponent = exponent;
+    out->length = i;
+    return TRUE;
+}
+
+// Powers of ten that are exact in a double.
+static const f64 exact_pow10_f64[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// The C-locale fallback for inputs that the exact fast paths can't handle. The copy
+// bounds the input to the scanned length and keeps strtod from reading further.
+#if defined(KPLATFORM_WINDOWS)
+typedef _locale_t number_locale;
+#define number_locale_create() _create_locale(LC_ALL, "C")
+#define number_strtod(str, end, locale) _strtod_l(str, end, locale)
+#define number_strtof(str, end, locale) _strtof_l(str, end, locale)
+#else
+typedef locale_t number_locale;
+#define number_locale_create() newlocale(LC_ALL_MASK, "C", (locale_t)0)
+#define number_strtod(str, end, locale) strtod_l(str, end, locale)
+#define number_strtof(str, end, locale) strtof_l(str, end, locale)
+#endif
+
+static number_locale c_locale;
+
+void string_number_initialize() {
+    if (!c_locale) {
+        c_locale = number_locale_create();
+    }
+}
+
+static f64 parse_fallback(const char* str, u64 length, b8 single) {
+    string_number_initialize();
+    char stack_buffer[128];
+    char* buffer = length < sizeof(stack_buffer) ? stack_buffer : kallocate(length + 1, MEMORY_TAG_STRING);
+    kcopy_memory(buffer, str, length);
+    buffer[length] = 0;
+    f64 result = single ? (f64)number_strtof(buffer, 0, c_locale) : number_strtod(buffer, 0, c_locale);
+    if (buffer != stack_buffer) {
+        kfree(buffer, length + 1, MEMORY_TAG_STRING);
+    }
+    return result;
+}
+
+u64 string_parse_f64(const char* str, u64 length, f64* out_value) {
+    decimal_parse d;
+    if (!scan_decimal(str, length, &d)) {
+        return 0;
+    }
+
+    f64 value;
+    if (d.nan) {
+        value = __builtin_nan("");
+    } else if (d.infinity) {
+        value = __builtin_inf();
+    } else if (d.mantissa == 0) {
+        value = 0.0;
+    } else if (!d.truncated && d.mantissa <= (1ull << 53) && d.exponent >= -22 && d.exponent <= 22 + 15) {
+        // Clinger's fast path: the mantissa and power of ten are both exact, so a single
+        // correctly rounded multiply or divide gives the correctly rounded result. Exponents
+        // just above 22 can move into the mantissa if it stays exact.
+        value = (f64)d.mantissa;
+        if (d.exponent < 0) {
+            value /= exact_pow10_f64[-d.exponent];
+        } else if (d.exponent <= 22) {
+            value *= exact_pow10_f64[d.exponent];
+        } else {
+            value *= exact_pow10_f64[d.exponent - 22];
+            if (value >= (f64)(1ull << 53)) {
+                value = parse_fallback(str, d.length, FALSE);
+                d.negative = FALSE;
+            } else {
+                value *= exact_pow10_f64[22];
+            }
+        }
+    } else {
+        value = parse_fallback(str, d.length, FALSE);
+        d.negative = FALSE;
+    }
+
+    *out_value = d.negative ? -value : value;
+    return d.length;
+}
+
+u64 string_parse_f32(const char* str, u64 length, f32* out_value) {
+    decimal_parse d;
+    if (!scan_decimal(str, length, &d)) {
+        return 0;
+    }
+
+    f32 value;
+    if (d.nan) {
+        value = __builtin_nanf("");
+    } else if (d.infinity) {
+        value = __builtin_inff();
+    } else if (d.mantissa == 0) {
+        value = 0.0f;
+    } else if (!d.truncated && d.mantissa <= (1ull << 53) && d.exponent >= -22 && d.exponent <= 22) {
+        // The double fast path gives the correctly rounded double. Rounding that again to
+        // float is only wrong when it lands exactly on the midpoint between two floats,
+        // since the midpoints are themselves representable as doubles.
+        f64 wide = (f64)d.mantissa;
+        wide = d.exponent < 0 ? wide / exact_pow10_f64[-d.exponent] : wide * exact_pow10_f64[d.exponent];
+        value = (f32)wide;
+        if ((f64)value != wide) {
+            // The adjacent float on wide's side. value is positive and finite here, so
+            // stepping its bit pattern moves one float away from or towards zero.
+            u32 bits;
+            kcopy_memory(&bits, &value, sizeof(bits));
+            bits = (f64)value < wide ? bits + 1 : bits - 1;
+            f32 neighbour;
+            kcopy_memory(&neighbour, &bits, sizeof(neighbour));
+            if (wide == ((f64)value + (f64)neighbour) * 0.5) {
+                value = (f32)parse_fallback(str, d.length, TRUE);
+                d.negative = FALSE;
+            }
+        }
+    } else {
+        value = (f32)parse_fallback(str, d.length, TRUE);
+        d.negative = FALSE;
+    }
+
+    *out_value = d.negative ? -value : value;
+    return d.length;
+}
@@ -0,0 +1,167 @@
+// Vectorized string kernels. This file is included by str.c once per instruction set,
+// with the following defined beforehand:
+//   SIMD_SUFFIX       Appended to every function name (e.g. _sse2).
+//   SIMD_WIDTH        Vector width in bytes.
+//   SIMD_FULL_MASK    A movemask result with every lane set.
+//   SIMD_TARGET       Function attributes required to compile the instruction set.
+//   simd_vec and the simd_* operations below.
+//
+// Scans of a single string use aligned loads, which can never cross into an unmapped
+// page, so reading past the terminator is safe. Those reads are invisible to the
+// program but not to AddressSanitizer, hence the no_sanitize attribute. Comparisons of
+// two strings cannot align both, so they fall back to bytes near page boundaries.
+
+#define SIMD_CONCAT_(a, b) a##b
+#define SIMD_CONCAT(a, b) SIMD_CONCAT_(a, b)
+#define SIMD_FN(name) SIMD_CONCAT(name, SIMD_SUFFIX)
+
+#ifndef SIMD_NO_SANITIZE
+#if defined(__GNUC__)
+#define SIMD_NO_SANITIZE __attribute__((no_sanitize_address))
+#else
+#define SIMD_NO_SANITIZE
+#endif
+#define SIMD_PAGE_SIZE 4096
+#endif
+
+// TRUE if a full vector can be loaded from p without touching the next page.
+#define simd_page_safe(p) ((((u64)(p)) & (SIMD_PAGE_SIZE - 1)) <= SIMD_PAGE_SIZE - SIMD_WIDTH)
+
+SIMD_TARGET SIMD_NO_SANITIZE static u64 SIMD_FN(string_length)(const char* str) {
+    const simd_vec zero = simd_zero();
+    u64 offset = (u64)str & (SIMD_WIDTH - 1);
+    const char* p = str - offset;
+    u32 mask = simd_movemask(simd_cmpeq(simd_load(p), zero)) >> offset;
+    if (mask) {
+        return __builtin_ctz(mask);
+    }
+    for (p += SIMD_WIDTH;; p += SIMD_WIDTH) {
+        mask = simd_movemask(simd_cmpeq(simd_load(p), zero));
+        if (mask) {
+            return (u64)(p - str) + __builtin_ctz(mask);
+        }
+    }
+}
+
+SIMD_TARGET SIMD_NO_SANITIZE static const char* SIMD_FN(string_find_char)(const char* str, char c) {
+    const simd_vec zero = simd_zero();
+    const simd_vec needle = simd_set1(c);
+    u64 offset = (u64)str & (SIMD_WIDTH - 1);
+    const char* p = str - offset;
+    simd_vec v = simd_load(p);
+    u32 mask = simd_movemask(simd_or(simd_cmpeq(v, zero), simd_cmpeq(v, needle))) >> offset;
+    const char* base = str;
+    while (!mask) {
+        p += SIMD_WIDTH;
+        base = p;
+        v = simd_load(p);
+        mask = simd_movemask(simd_or(simd_cmpeq(v, zero), simd_cmpeq(v, needle)));
+    }
+    // The first hit is either the character or the terminator.
+    const char* found = base + __builtin_ctz(mask);
+    return *found == c ? found : 0;
+}
+
+SIMD_TARGET SIMD_NO_SANITIZE static b8 SIMD_FN(strings_equal)(const char* str0, const char* str1) {
+    const simd_vec zero = simd_zero();
+    u64 i = 0;
+    for (;;) {
+        if (simd_page_safe(str0 + i) && simd_page_safe(str1 + i)) {
+            simd_vec a = simd_loadu(str0 + i);
+            simd_vec b = simd_loadu(str1 + i);
+            // First lane that differs or terminates str0.
+            u32 mask = ((~simd_movemask(simd_cmpeq(a, b))) | simd_movemask(simd_cmpeq(a, zero))) & SIMD_FULL_MASK;
+            if (mask) {
+                u32 index = __builtin_ctz(mask);
+                return str0[i + index] == str1[i + index];
+            }
+            i += SIMD_WIDTH;
+        } else {
+            char a = str0[i];
+            if (a != str1[i]) {
+                return FALSE;
+            }
+            if (!a) {
+                return TRUE;
+            }
+            ++i;
+        }
+    }
+}
+
+SIMD_TARGET static inline simd_vec SIMD_FN(simd_to_lower)(simd_vec v) {
+    // Signed compares leave bytes >= 0x80 untouched, which is correct for ASCII folding.
+    simd_vec upper = simd_and(simd_cmpgt(v, simd_set1('A' - 1)), simd_cmpgt(simd_set1('Z' + 1), v));
+    return simd_add8(v, simd_and(upper, simd_set1(0x20)));
+}
+
+SIMD_TARGET SIMD_NO_SANITIZE static b8 SIMD_FN(strings_equali)(const char* str0, const char* str1) {
+    const simd_vec zero = simd_zero();
+    u64 i = 0;
+    for (;;) {
+        if (simd_page_safe(str0 + i) && simd_page_safe(str1 + i)) {
+            simd_vec a = simd_loadu(str0 + i);
+            simd_vec b = simd_loadu(str1 + i);
+            simd_vec la = SIMD_FN(simd_to_lower)(a);
+            simd_vec lb = SIMD_FN(simd_to_lower)(b);
+            u32 mask = ((~simd_movemask(simd_cmpeq(la, lb))) | simd_movemask(simd_cmpeq(a, zero))) & SIMD_FULL_MASK;
+            if (mask) {
+                u32 index = __builtin_ctz(mask);
+                return char_to_lower(str0[i + index]) == char_to_lower(str1[i + index]);
+            }
+            i += SIMD_WIDTH;
+        } else {
+            char a = char_to_lower(str0[i]);
+            if (a != char_to_lower(str1[i])) {
+                return FALSE;
+            }
+            if (!a) {
+                return TRUE;
+            }
+            ++i;
+        }
+    }
+}
+
+SIMD_TARGET static const char* SIMD_FN(string_find)(const char* str, const char* substr) {
+    u64 substr_length = SIMD_FN(string_length)(substr);
+    if (substr_length == 0) {
+        return str;
+    }
+    if (substr_length == 1) {
+        return SIMD_FN(string_find_char)(str, substr[0]);
+    }
+    u64 length = SIMD_FN(string_length)(str);
+    if (length < substr_length) {
+        return 0;
+    }
+
+    // Filter candidate positions by matching both the first and last character of the
+    // substring, then verify the middle. Both loads stay within the string.
+    const simd_vec first = simd_set1(substr[0]);
+    const simd_vec last = simd_set1(substr[substr_length - 1]);
+    u64 i = 0;
+    for (; i + SIMD_WIDTH + substr_length - 1 <= length; i += SIMD_WIDTH) {
+        simd_vec a = simd_loadu(str + i);
+        simd_vec b = simd_loadu(str + i + substr_length - 1);
+        u32 mask = simd_movemask(simd_and(simd_cmpeq(a, first), simd_cmpeq(b, last)));
+        while (mask) {
+            u32 bit = __builtin_ctz(mask);
+            if (memcmp(str + i + bit + 1, substr + 1, substr_length - 2) == 0) {
+                return str + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    for (; i + substr_length <= length; ++i) {
+        if (str[i] == substr[0] && memcmp(str + i, substr, substr_length) == 0) {
+            return str + i;
+        }
+    }
+    return 0;
+}
+
+#undef simd_page_safe
+#undef SIMD_FN
+#undef SIMD_CONCAT
+#undef SIMD_CONCAT_
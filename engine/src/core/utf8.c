@@ -0,0 +1,203 @@
+#include "core/utf8.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define UTF8_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#define UTF8_ASCII_BLOCK 16
+
+// Returns the offset of the first non-ASCII byte in the block at str, or UTF8_ASCII_BLOCK
+// if the whole block is ASCII. The caller guarantees the block is in bounds.
+static inline u32 ascii_prefix(const u8* str) {
+#if UTF8_SSE2
+    u32 mask = (u32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)str));
+    return mask ? (u32)__builtin_ctz(mask) : UTF8_ASCII_BLOCK;
+#else
+    for (u32 i = 0; i < UTF8_ASCII_BLOCK; ++i) {
+        if (str[i] & 0x80) {
+            return i;
+        }
+    }
+    return UTF8_ASCII_BLOCK;
+#endif
+}
+
+u32 utf8_decode_codepoint(const char* str, u64 length, u32* out_codepoint) {
+    const u8* s = (const u8*)str;
+    if (length == 0) {
+        return 0;
+    }
+
+    u8 b0 = s[0];
+    if (b0 < 0x80) {
+        *out_codepoint = b0;
+        return 1;
+    }
+
+    // Valid range of the second byte depends on the lead byte; this is what rejects
+    // overlong encodings, surrogates and values beyond U+10FFFF.
+    u32 size;
+    u8 lo = 0x80, hi = 0xBF;
+    u32 codepoint;
+    if (b0 >= 0xC2 && b0 <= 0xDF) {
+        size = 2;
+        codepoint = b0 & 0x1F;
+    } else if (b0 >= 0xE0 && b0 <= 0xEF) {
+        size = 3;
+        codepoint = b0 & 0x0F;
+        if (b0 == 0xE0) {
+            lo = 0xA0;
+        } else if (b0 == 0xED) {
+            hi = 0x9F;
+        }
+    } else if (b0 >= 0xF0 && b0 <= 0xF4) {
+        size = 4;
+        codepoint = b0 & 0x07;
+        if (b0 == 0xF0) {
+            lo = 0x90;
+        } else if (b0 == 0xF4) {
+            hi = 0x8F;
+        }
+    } else {
+        return 0;
+    }
+
+    if (length < size) {
+        return 0;
+    }
+    if (s[1] < lo || s[1] > hi) {
+        return 0;
+    }
+    codepoint = (codepoint << 6) | (s[1] & 0x3F);
+    for (u32 i = 2; i < size; ++i) {
+        if ((s[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+        codepoint = (codepoint << 6) | (s[i] & 0x3F);
+    }
+
+    *out_codepoint = codepoint;
+    return size;
+}
+
+b8 utf8_validate(const char* str, u64 length, u64* out_error_offset) {
+    const u8* s = (const u8*)str;
+    u64 i = 0;
+    while (i < length) {
+        // Skip runs of ASCII a block at a time.
+        if (i + UTF8_ASCII_BLOCK <= length) {
+            u32 ascii = ascii_prefix(s + i);
+            i += ascii;
+            if (ascii == UTF8_ASCII_BLOCK) {
+                continue;
+            }
+        } else if (s[i] < 0x80) {
+            ++i;
+            continue;
+        }
+
+        u32 codepoint;
+        u32 size = utf8_decode_codepoint(str + i, length - i, &codepoint);
+        if (size == 0) {
+            if (out_error_offset) {
+                *out_error_offset = i;
+            }
+            return FALSE;
+        }
+        i += size;
+    }
+    return TRUE;
+}
+
+u64 utf8_decode(const char* str, u64 length, u32* out_codepoints, u64 max_codepoints, u64* out_consumed) {
+    const u8* s = (const u8*)str;
+    u64 i = 0;
+    u64 count = 0;
+    if (!out_codepoints) {
+        max_codepoints = (u64)-1;
+    }
+
+    while (i < length && count < max_codepoints) {
+        // Widen whole blocks of ASCII straight to codepoints.
+        if (i + UTF8_ASCII_BLOCK <= length && count + UTF8_ASCII_BLOCK <= max_codepoints) {
+#if UTF8_SSE2
+            __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+            if (_mm_movemask_epi8(v) == 0) {
+                if (out_codepoints) {
+                    __m128i zero = _mm_setzero_si128();
+                    __m128i lo = _mm_unpacklo_epi8(v, zero);
+                    __m128i hi = _mm_unpackhi_epi8(v, zero);
+                    __m128i* dest = (__m128i*)(out_codepoints + count);
+                    _mm_storeu_si128(dest + 0, _mm_unpacklo_epi16(lo, zero));
+                    _mm_storeu_si128(dest + 1, _mm_unpackhi_epi16(lo, zero));
+                    _mm_storeu_si128(dest + 2, _mm_unpacklo_epi16(hi, zero));
+                    _mm_storeu_si128(dest + 3, _mm_unpackhi_epi16(hi, zero));
+                }
+                i += UTF8_ASCII_BLOCK;
+                count += UTF8_ASCII_BLOCK;
+                continue;
+            }
+#else
+            if (ascii_prefix(s + i) == UTF8_ASCII_BLOCK) {
+                if (out_codepoints) {
+                    for (u32 j = 0; j < UTF8_ASCII_BLOCK; ++j) {
+                        out_codepoints[count + j] = s[i + j];
+                    }
+                }
+                i += UTF8_ASCII_BLOCK;
+                count += UTF8_ASCII_BLOCK;
+                continue;
+            }
+#endif
+        }
+
+        u32 codepoint;
+        u32 size = utf8_decode_codepoint(str + i, length - i, &codepoint);
+        if (size == 0) {
+            codepoint = UTF8_REPLACEMENT_CHARACTER;
+            size = 1;
+        }
+        if (out_codepoints) {
+            out_codepoints[count] = codepoint;
+        }
+        count++;
+        i += size;
+    }
+
+    if (out_consumed) {
+        *out_consumed = i;
+    }
+    return count;
+}
+
+u64 utf8_codepoint_count(const char* str, u64 length) {
+    return utf8_decode(str, length, 0, 0, 0);
+}
+
+u32 utf8_encode(u32 codepoint, char* out_bytes) {
+    u8* out = (u8*)out_bytes;
+    if (codepoint < 0x80) {
+        out[0] = (u8)codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        out[0] = (u8)(0xC0 | (codepoint >> 6));
+        out[1] = (u8)(0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+    if (codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        codepoint = UTF8_REPLACEMENT_CHARACTER;
+    }
+    if (codepoint < 0x10000) {
+        out[0] = (u8)(0xE0 | (codepoint >> 12));
+        out[1] = (u8)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = (u8)(0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+    out[0] = (u8)(0xF0 | (codepoint >> 18));
+    out[1] = (u8)(0x80 | ((codepoint >> 12) & 0x3F));
+    out[2] = (u8)(0x80 | ((codepoint >> 6) & 0x3F));
+    out[3] = (u8)(0x80 | (codepoint & 0x3F));
+    return 4;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+UTF-8 validation, decoding and encoding per RFC 3629: overlong forms, surrogates
+(U+D800-U+DFFF) and values above U+10FFFF are rejected. Runs of ASCII are detected
+16 bytes at a time and skipped (or widened straight to codepoints) without going
+through the per-sequence decoder, which is what dominates typical asset manifests
+and localization tables.
+
+All functions take an explicit byte length and do not require zero termination.
+*/
+
+// The codepoint substituted for invalid input when decoding.
+#define UTF8_REPLACEMENT_CHARACTER 0xFFFD
+
+// The maximum number of bytes used to encode a single codepoint.
+#define UTF8_MAX_SEQUENCE_LENGTH 4
+
+/**
+ * Validates that the given bytes are well-formed UTF-8.
+ * @param str The bytes to validate.
+ * @param length The number of bytes.
+ * @param out_error_offset If invalid, receives the offset of the first invalid sequence. Can be 0/NULL.
+ * @returns TRUE if the input is valid; otherwise FALSE.
+ */
+VAPI b8 utf8_validate(const char* str, u64 length, u64* out_error_offset);
+
+/**
+ * Decodes a single codepoint.
+ * @param str The bytes to decode from.
+ * @param length The number of bytes available.
+ * @param out_codepoint Receives the decoded codepoint.
+ * @returns The number of bytes consumed (1-4), or 0 if the sequence is invalid or truncated.
+ */
+VAPI u32 utf8_decode_codepoint(const char* str, u64 length, u32* out_codepoint);
+
+/**
+ * Decodes the given bytes to codepoints. Each invalid byte is decoded as
+ * UTF8_REPLACEMENT_CHARACTER. Decoding stops when max_codepoints have been written.
+ * @param str The bytes to decode.
+ * @param length The number of bytes.
+ * @param out_codepoints The array to write codepoints to. If 0/NULL, codepoints are only counted.
+ * @param max_codepoints The capacity of out_codepoints. Ignored if out_codepoints is 0/NULL.
+ * @param out_consumed Receives the number of bytes consumed. Can be 0/NULL.
+ * @returns The number of codepoints decoded.
+ */
+VAPI u64 utf8_decode(const char* str, u64 length, u32* out_codepoints, u64 max_codepoints, u64* out_consumed);
+
+// Returns the number of codepoints in the given bytes, counting invalid bytes as one each.
+VAPI u64 utf8_codepoint_count(const char* str, u64 length);
+
+/**
+ * Encodes a codepoint as UTF-8.
+ * @param codepoint The codepoint to encode. Invalid codepoints encode UTF8_REPLACEMENT_CHARACTER.
+ * @param out_bytes Receives up to UTF8_MAX_SEQUENCE_LENGTH bytes. Not zero-terminated.
+ * @returns The number of bytes written.
+ */
+VAPI u32 utf8_encode(u32 codepoint, char* out_bytes);
@@ -16,7 +16,7 @@ int main(void) {
     initialize_memory();
 
     // Request the game instance from the application.
-    game game_inst;
+    game game_inst = {};
     if (!create_game(&game_inst)) {
         vfatal("Could not create game!");
         return -1;
@@ -27,9 +27,14 @@ void* platform_set_memory(void* dest, i32 value, u64 size);
 void platform_console_write(const char* message, u8 colour);
 void platform_console_write_error(const char* message, u8 colour);
 
-f64 platform_get_absolute_time();
+// Monotonic time in nanoseconds from an unspecified starting point.
+u64 platform_get_absolute_time_ns();
 
 // Sleep on the thread for the provided ms. This blocks the main thread.
 // Should only be used for giving time back to the OS for unused update power.
 // Therefore it is not exported.
-void platform_sleep(u64 ms);
\ No newline at end of file
+void platform_sleep(u64 ms);
+
+// Sleep on the thread until the monotonic time (see platform_get_absolute_time_ns) reaches
+// the deadline. The OS may wake the thread late, typically by tens of microseconds.
+void platform_sleep_until_ns(u64 deadline_ns);
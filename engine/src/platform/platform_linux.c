@@ -6,15 +6,18 @@
 #include "core/logger.h"
 #include "core/event.h"
 #include "core/input.h"
+#include "platform/platform_linux_gamepad.h"
 
 #include "containers/darray.h"
 
 #include <xcb/xcb.h>
+#include <xcb/xinput.h>  // sudo apt-get install libxcb-xinput-dev
 #include <X11/keysym.h>
 #include <X11/XKBlib.h>  // sudo apt-get install libx11-dev
 #include <X11/Xlib.h>
 #include <X11/Xlib-xcb.h>  // sudo apt-get install libxkbcommon-x11-dev
 #include <sys/time.h>
+#include <errno.h>
 
 #if _POSIX_C_SOURCE >= 199309L
 #include <time.h>  // nanosleep
@@ -39,8 +42,16 @@ typedef struct internal_state {
     xcb_atom_t wm_protocols;
     xcb_atom_t wm_delete_win;
     VkSurfaceKHR surface;
+    // Major opcode of the XInput extension, if XI 2.2 raw events are available; otherwise 0.
+    u8 xinput_opcode;
+    // Raw motion is delivered regardless of focus, so it is only used while focused.
+    b8 has_focus;
 } internal_state;
 
+// Selects XInput2 raw motion events on the root window, if the server supports XI 2.2.
+static void platform_linux_select_raw_motion(internal_state* state);
+static void platform_linux_process_raw_motion(const xcb_input_raw_motion_event_t* event);
+
 // Key translation
 keys translate_keycode(u32 x_keycode);
 
@@ -94,7 +105,7 @@ b8 platform_startup(
     u32 event_values = XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE |
                        XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE |
                        XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_POINTER_MOTION |
-                       XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+                       XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_FOCUS_CHANGE;
 
     // Values to be sent over XCB (bg colour, events)
     u32 value_list[] = {state->screen->black_pixel, event_values};
@@ -159,6 +170,13 @@ b8 platform_startup(
         1,
         &wm_delete_reply->atom);
 
+    // A newly mapped window normally receives focus; a FocusOut corrects this if not.
+    state->has_focus = TRUE;
+    platform_linux_select_raw_motion(state);
+
+    // Gamepads are optional; the engine runs without them if the thread cannot start.
+    platform_linux_gamepad_startup();
+
     // Map the window to the screen
     xcb_map_window(state->connection, state->window);
 
@@ -176,6 +194,8 @@ void platform_shutdown(platform_state* plat_state) {
     // Simply cold-cast to the known type.
     internal_state* state = (internal_state*)plat_state->internal_state;
 
+    platform_linux_gamepad_shutdown();
+
     // Turn key repeats back on since this is global for the OS... just... wow.
     XAutoRepeatOn(state->display);
 
@@ -214,8 +234,8 @@ b8 platform_pump_messages(platform_state* plat_state) {
 
                 keys key = translate_keycode(key_sym);
 
-                // Pass to the input subsystem for processing.
-                input_process_key(key, pressed);
+                // Pass to the input subsystem for processing, with the server time of the event.
+                input_process_key(key, pressed, kb_event->time);
             } break;
             case XCB_BUTTON_PRESS:
             case XCB_BUTTON_RELEASE: {
@@ -236,7 +256,7 @@ b8 platform_pump_messages(platform_state* plat_state) {
 
                 // Pass over to the input subsystem.
                 if (mouse_button != BUTTON_MAX_BUTTONS) {
-                    input_process_button(mouse_button, pressed);
+                    input_process_button(mouse_button, pressed, mouse_event->time);
                 }
             } break;
             case XCB_MOTION_NOTIFY: {
@@ -252,15 +272,32 @@ b8 platform_pump_messages(platform_state* plat_state) {
                 // The application layer can decide what to do with this.
                 xcb_configure_notify_event_t *configure_event = (xcb_configure_notify_event_t *)event;
 
-                // Fire the event. The application layer should pick this up, but not handle it
-                // as it shouldn be visible to other parts of the application.
-                event_context context;
+                // Post the event. The application layer should pick this up, but not handle it
+                // as it shouldn be visible to other parts of the application. Dragging the window
+                // produces many of these; the event system collapses them to one per frame.
+                event_context context = {};
                 context.data.u16[0] = configure_event->width;
                 context.data.u16[1] = configure_event->height;
-                event_fire(EVENT_CODE_RESIZED, 0, context);
+                event_post(EVENT_CODE_RESIZED, 0, context);
                 
             } break;
 
+            case XCB_FOCUS_IN:
+            case XCB_FOCUS_OUT: {
+                // Ignore the transient focus changes caused by keyboard grabs.
+                xcb_focus_in_event_t* focus_event = (xcb_focus_in_event_t*)event;
+                if (focus_event->mode == XCB_NOTIFY_MODE_NORMAL || focus_event->mode == XCB_NOTIFY_MODE_WHILE_GRABBED) {
+                    state->has_focus = (event->response_type & ~0x80) == XCB_FOCUS_IN;
+                }
+            } break;
+            case XCB_GE_GENERIC: {
+                // XInput2 events arrive as generic events.
+                xcb_ge_generic_event_t* generic_event = (xcb_ge_generic_event_t*)event;
+                if (state->xinput_opcode && generic_event->extension == state->xinput_opcode &&
+                    generic_event->event_type == XCB_INPUT_RAW_MOTION && state->has_focus) {
+                    platform_linux_process_raw_motion((xcb_input_raw_motion_event_t*)event);
+                }
+            } break;
             case XCB_CLIENT_MESSAGE: {
                 cm = (xcb_client_message_event_t*)event;
 
@@ -276,9 +313,79 @@ b8 platform_pump_messages(platform_state* plat_state) {
 
         free(event);
     }
+
+    gamepad_state gamepads[INPUT_MAX_GAMEPADS];
+    platform_linux_gamepad_read(gamepads);
+    for (u32 i = 0; i < INPUT_MAX_GAMEPADS; ++i) {
+        input_process_gamepad(i, &gamepads[i]);
+    }
     return !quit_flagged;
 }
 
+static void platform_linux_select_raw_motion(internal_state* state) {
+    state->xinput_opcode = 0;
+
+    const xcb_query_extension_reply_t* extension = xcb_get_extension_data(state->connection, &xcb_input_id);
+    if (!extension || !extension->present) {
+        vwarn("XInput extension not available; raw mouse motion disabled.");
+        return;
+    }
+
+    // Raw events on the root window need XI 2.1; 2.2 is requested as it fixes their delivery
+    // while another client has a grab.
+    xcb_input_xi_query_version_cookie_t version_cookie = xcb_input_xi_query_version(state->connection, 2, 2);
+    xcb_input_xi_query_version_reply_t* version = xcb_input_xi_query_version_reply(state->connection, version_cookie, 0);
+    if (!version || version->major_version < 2 || (version->major_version == 2 && version->minor_version < 2)) {
+        vwarn("XInput 2.2 not supported by the X server; raw mouse motion disabled.");
+        free(version);
+        return;
+    }
+    free(version);
+
+    struct {
+        xcb_input_event_mask_t head;
+        u32 mask;
+    } mask;
+    mask.head.deviceid = XCB_INPUT_DEVICE_ALL_MASTER;
+    mask.head.mask_len = 1;
+    mask.mask = XCB_INPUT_XI_EVENT_MASK_RAW_MOTION;
+    xcb_generic_error_t* error = xcb_request_check(
+        state->connection,
+        xcb_input_xi_select_events_checked(state->connection, state->screen->root, 1, &mask.head));
+    if (error) {
+        vwarn("Failed to select XInput raw motion events (error %u); raw mouse motion disabled.", error->error_code);
+        free(error);
+        return;
+    }
+
+    state->xinput_opcode = extension->major_opcode;
+    input_set_raw_mouse_motion_available(TRUE);
+}
+
+static void platform_linux_process_raw_motion(const xcb_input_raw_motion_event_t* event) {
+    // Values are only sent for the valuators set in the mask, in valuator order. For
+    // relative pointers, valuators 0 and 1 hold the x and y deltas as 32.32 fixed point,
+    // before pointer acceleration.
+    const u32* valuator_mask = xcb_input_raw_button_press_valuator_mask(event);
+    i32 mask_length = xcb_input_raw_button_press_valuator_mask_length(event);
+    const xcb_input_fp3232_t* values = xcb_input_raw_button_press_axisvalues_raw(event);
+    if (mask_length <= 0) {
+        return;
+    }
+
+    f64 delta[2] = {0, 0};
+    u32 value_index = 0;
+    for (u32 valuator = 0; valuator < 2; ++valuator) {
+        if (valuator_mask[0] & (1u << valuator)) {
+            const xcb_input_fp3232_t* v = &values[value_index++];
+            delta[valuator] = v->integral + v->frac / 4294967296.0;
+        }
+    }
+    if (value_index > 0) {
+        input_process_mouse_raw_motion((f32)delta[0], (f32)delta[1]);
+    }
+}
+
 void* platform_allocate(u64 size, b8 aligned) {
     return malloc(size);
 }
@@ -306,10 +413,10 @@ void platform_console_write_error(const char* message, u8 colour) {
     printf("\033[%sm%s\033[0m", colour_strings[colour], message);
 }
 
-f64 platform_get_absolute_time() {
+u64 platform_get_absolute_time_ns() {
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
-    return now.tv_sec + now.tv_nsec * 0.000000001;
+    return (u64)now.tv_sec * 1000000000ULL + (u64)now.tv_nsec;
 }
 
 void platform_sleep(u64 ms) {
@@ -326,6 +433,15 @@ void platform_sleep(u64 ms) {
 #endif
 }
 
+void platform_sleep_until_ns(u64 deadline_ns) {
+    struct timespec ts;
+    ts.tv_sec = deadline_ns / 1000000000ULL;
+    ts.tv_nsec = deadline_ns % 1000000000ULL;
+    // An absolute deadline is unaffected by interruptions and by time spent setting up the sleep.
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR) {
+    }
+}
+
 void platform_get_required_extension_names(const char ***names_darray) {
     darray_push(*names_darray, &"VK_KHR_xcb_surface");  // VK_KHR_xlib_surface?
 }
@@ -0,0 +1,445 @@
+// For pthread_setname_np.
+#define _GNU_SOURCE
+
+#include "platform_linux_gamepad.h"
+
+#if KPLATFORM_LINUX
+
+#include "core/logger.h"
+#include "core/mem.h"
+
+#include <linux/input.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// Where evdev nodes are found. Overridable for testing against fake devices.
+#ifndef LINUX_GAMEPAD_DEVICE_DIR
+#define LINUX_GAMEPAD_DEVICE_DIR "/dev/input"
+#endif
+
+// Events read per read() call.
+#define GAMEPAD_READ_BATCH 64
+
+#define BIT_TEST(bits, bit) (((bits)[(bit) / 8] >> ((bit) % 8)) & 1)
+
+typedef struct gamepad_axis_info {
+    i32 minimum;
+    i32 maximum;
+    // Values within this distance of the centre read as 0 (sticks only).
+    i32 flat;
+} gamepad_axis_info;
+
+// One side of a pad's double buffer.
+typedef struct gamepad_snapshot {
+    // Odd while the gamepad thread is writing the state.
+    _Atomic u32 sequence;
+    gamepad_state state;
+} gamepad_snapshot;
+
+typedef struct gamepad_device {
+    // -1 if the slot is free. Only touched by the gamepad thread.
+    i32 fd;
+    char node[32];
+    gamepad_axis_info axes[GAMEPAD_AXIS_MAX_AXES];
+    // The state being assembled from the current report. Only touched by the gamepad thread.
+    gamepad_state working;
+    // Set after SYN_DROPPED; events are ignored until the next report, then state is re-read.
+    b8 dropped;
+
+    gamepad_snapshot snapshots[2];
+    // Index of the most recently published snapshot.
+    _Atomic u32 front;
+} gamepad_device;
+
+typedef struct gamepad_backend_state {
+    pthread_t thread;
+    b8 running;
+    // Written to wake the thread for shutdown.
+    i32 wake_fd;
+    i32 inotify_fd;
+    gamepad_device devices[INPUT_MAX_GAMEPADS];
+} gamepad_backend_state;
+
+static gamepad_backend_state state;
+
+// Maps an evdev key code to a gamepad button, or returns GAMEPAD_BUTTON_MAX_BUTTONS.
+static gamepad_buttons gamepad_button_from_code(u16 code) {
+    switch (code) {
+        case BTN_SOUTH: return GAMEPAD_BUTTON_A;
+        case BTN_EAST: return GAMEPAD_BUTTON_B;
+        case BTN_WEST: return GAMEPAD_BUTTON_X;
+        case BTN_NORTH: return GAMEPAD_BUTTON_Y;
+        case BTN_TL: return GAMEPAD_BUTTON_LEFT_SHOULDER;
+        case BTN_TR: return GAMEPAD_BUTTON_RIGHT_SHOULDER;
+        case BTN_SELECT: return GAMEPAD_BUTTON_BACK;
+        case BTN_START: return GAMEPAD_BUTTON_START;
+        case BTN_MODE: return GAMEPAD_BUTTON_GUIDE;
+        case BTN_THUMBL: return GAMEPAD_BUTTON_LEFT_STICK;
+        case BTN_THUMBR: return GAMEPAD_BUTTON_RIGHT_STICK;
+        case BTN_DPAD_UP: return GAMEPAD_BUTTON_DPAD_UP;
+        case BTN_DPAD_DOWN: return GAMEPAD_BUTTON_DPAD_DOWN;
+        case BTN_DPAD_LEFT: return GAMEPAD_BUTTON_DPAD_LEFT;
+        case BTN_DPAD_RIGHT: return GAMEPAD_BUTTON_DPAD_RIGHT;
+        default: return GAMEPAD_BUTTON_MAX_BUTTONS;
+    }
+}
+
+// Maps an evdev absolute axis code to a gamepad axis, or returns GAMEPAD_AXIS_MAX_AXES.
+// Triggers are reported as ABS_Z/ABS_RZ by most drivers and ABS_BRAKE/ABS_GAS by some.
+static gamepad_axes gamepad_axis_from_code(u16 code) {
+    switch (code) {
+        case ABS_X: return GAMEPAD_AXIS_LEFT_X;
+        case ABS_Y: return GAMEPAD_AXIS_LEFT_Y;
+        case ABS_RX: return GAMEPAD_AXIS_RIGHT_X;
+        case ABS_RY: return GAMEPAD_AXIS_RIGHT_Y;
+        case ABS_Z:
+        case ABS_BRAKE: return GAMEPAD_AXIS_LEFT_TRIGGER;
+        case ABS_RZ:
+        case ABS_GAS: return GAMEPAD_AXIS_RIGHT_TRIGGER;
+        default: return GAMEPAD_AXIS_MAX_AXES;
+    }
+}
+
+static f32 gamepad_axis_normalize(const gamepad_axis_info* info, gamepad_axes axis, i32 value) {
+    i32 range = info->maximum - info->minimum;
+    if (range <= 0) {
+        return 0;
+    }
+    if (axis == GAMEPAD_AXIS_LEFT_TRIGGER || axis == GAMEPAD_AXIS_RIGHT_TRIGGER) {
+        f32 v = (f32)(value - info->minimum) / (f32)range;
+        return v < 0 ? 0 : (v > 1 ? 1 : v);
+    }
+    // Computed in double width: ranges can span the full i32.
+    f64 centre = ((f64)info->minimum + (f64)info->maximum) * 0.5;
+    f64 offset = (f64)value - centre;
+    if (offset <= info->flat && offset >= -info->flat) {
+        return 0;
+    }
+    f64 v = offset / (range * 0.5);
+    return (f32)(v < -1 ? -1 : (v > 1 ? 1 : v));
+}
+
+static void gamepad_set_button(gamepad_state* s, gamepad_buttons button, b8 down) {
+    if (down) {
+        s->buttons |= 1u << button;
+    } else {
+        s->buttons &= ~(1u << button);
+    }
+}
+
+// Applies one evdev event to the working state.
+static void gamepad_apply_event(gamepad_device* device, const struct input_event* e) {
+    if (e->type == EV_KEY) {
+        gamepad_buttons button = gamepad_button_from_code(e->code);
+        if (button != GAMEPAD_BUTTON_MAX_BUTTONS) {
+            // Value 2 is autorepeat, which still means down.
+            gamepad_set_button(&device->working, button, e->value != 0);
+        }
+    } else if (e->type == EV_ABS) {
+        if (e->code == ABS_HAT0X) {
+            gamepad_set_button(&device->working, GAMEPAD_BUTTON_DPAD_LEFT, e->value < 0);
+            gamepad_set_button(&device->working, GAMEPAD_BUTTON_DPAD_RIGHT, e->value > 0);
+        } else if (e->code == ABS_HAT0Y) {
+            gamepad_set_button(&device->working, GAMEPAD_BUTTON_DPAD_UP, e->value < 0);
+            gamepad_set_button(&device->working, GAMEPAD_BUTTON_DPAD_DOWN, e->value > 0);
+        } else {
+            gamepad_axes axis = gamepad_axis_from_code(e->code);
+            if (axis != GAMEPAD_AXIS_MAX_AXES) {
+                device->working.axes[axis] = gamepad_axis_normalize(&device->axes[axis], axis, e->value);
+            }
+        }
+    }
+}
+
+// Re-reads the complete device state, after opening or after the kernel dropped events.
+static void gamepad_resync(gamepad_device* device) {
+    u8 key_bits[KEY_MAX / 8 + 1] = {};
+    ioctl(device->fd, EVIOCGKEY(sizeof(key_bits)), key_bits);
+
+    struct input_event e = {};
+    e.type = EV_KEY;
+    for (u16 code = BTN_MISC; code <= BTN_DPAD_RIGHT; ++code) {
+        if (gamepad_button_from_code(code) != GAMEPAD_BUTTON_MAX_BUTTONS) {
+            e.code = code;
+            e.value = BIT_TEST(key_bits, code);
+            gamepad_apply_event(device, &e);
+        }
+    }
+
+    e.type = EV_ABS;
+    for (u16 code = 0; code < ABS_MISC; ++code) {
+        struct input_absinfo info;
+        if (ioctl(device->fd, EVIOCGABS(code), &info) < 0) {
+            continue;
+        }
+        e.code = code;
+        e.value = info.value;
+        gamepad_apply_event(device, &e);
+    }
+}
+
+static void gamepad_publish(gamepad_device* device) {
+    u32 back = atomic_load_explicit(&device->front, memory_order_relaxed) ^ 1;
+    gamepad_snapshot* snapshot = &device->snapshots[back];
+
+    // Sequence lock: odd while writing, so a reader that overlaps retries.
+    u32 sequence = atomic_load_explicit(&snapshot->sequence, memory_order_relaxed);
+    atomic_store_explicit(&snapshot->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    snapshot->state = device->working;
+    atomic_store_explicit(&snapshot->sequence, sequence + 2, memory_order_release);
+
+    atomic_store_explicit(&device->front, back, memory_order_release);
+}
+
+static void gamepad_close(gamepad_device* device) {
+    vinfo("Gamepad at %s/%s disconnected.", LINUX_GAMEPAD_DEVICE_DIR, device->node);
+    close(device->fd);
+    device->fd = -1;
+    device->node[0] = 0;
+    kzero_memory(&device->working, sizeof(gamepad_state));
+    gamepad_publish(device);
+}
+
+// Opens the node if it is a gamepad and a slot is free.
+static void gamepad_try_open(const char* node) {
+    if (strncmp(node, "event", 5) != 0) {
+        return;
+    }
+    gamepad_device* slot = 0;
+    for (u32 i = 0; i < INPUT_MAX_GAMEPADS; ++i) {
+        if (state.devices[i].fd >= 0 && strcmp(state.devices[i].node, node) == 0) {
+            return;
+        }
+        if (!slot && state.devices[i].fd < 0) {
+            slot = &state.devices[i];
+        }
+    }
+    if (!slot) {
+        return;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s/%s", LINUX_GAMEPAD_DEVICE_DIR, node);
+    i32 fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        // Usually not a gamepad the user has access to.
+        return;
+    }
+
+    u8 key_bits[KEY_MAX / 8 + 1] = {};
+    if (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(key_bits)), key_bits) < 0 || !BIT_TEST(key_bits, BTN_GAMEPAD)) {
+        close(fd);
+        return;
+    }
+
+    char name[128] = "unknown";
+    ioctl(fd, EVIOCGNAME(sizeof(name)), name);
+
+    slot->fd = fd;
+    snprintf(slot->node, sizeof(slot->node), "%s", node);
+    slot->dropped = FALSE;
+    kzero_memory(slot->axes, sizeof(slot->axes));
+    for (u16 code = 0; code < ABS_MISC; ++code) {
+        gamepad_axes axis = gamepad_axis_from_code(code);
+        struct input_absinfo info;
+        if (axis != GAMEPAD_AXIS_MAX_AXES && ioctl(fd, EVIOCGABS(code), &info) == 0) {
+            slot->axes[axis].minimum = info.minimum;
+            slot->axes[axis].maximum = info.maximum;
+            slot->axes[axis].flat = info.flat;
+        }
+    }
+
+    kzero_memory(&slot->working, sizeof(gamepad_state));
+    slot->working.connected = TRUE;
+    gamepad_resync(slot);
+    gamepad_publish(slot);
+    vinfo("Gamepad '%s' connected at %s.", name, path);
+}
+
+static void gamepad_read(gamepad_device* device) {
+    struct input_event events[GAMEPAD_READ_BATCH];
+    for (;;) {
+        ssize_t bytes = read(device->fd, events, sizeof(events));
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN) {
+                // ENODEV once unplugged.
+                gamepad_close(device);
+            }
+            return;
+        }
+        if (bytes == 0) {
+            gamepad_close(device);
+            return;
+        }
+
+        u32 count = (u32)(bytes / sizeof(struct input_event));
+        for (u32 i = 0; i < count; ++i) {
+            const struct input_event* e = &events[i];
+            if (e->type == EV_SYN && e->code == SYN_DROPPED) {
+                device->dropped = TRUE;
+            } else if (e->type == EV_SYN && e->code == SYN_REPORT) {
+                if (device->dropped) {
+                    device->dropped = FALSE;
+                    gamepad_resync(device);
+                }
+                gamepad_publish(device);
+            } else if (!device->dropped) {
+                gamepad_apply_event(device, e);
+            }
+        }
+    }
+}
+
+static void gamepad_handle_inotify() {
+    _Alignas(struct inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t bytes = read(state.inotify_fd, buffer, sizeof(buffer));
+        if (bytes <= 0) {
+            return;
+        }
+        for (char* p = buffer; p < buffer + bytes;) {
+            const struct inotify_event* e = (const struct inotify_event*)p;
+            // Permissions are usually fixed up by udev after the node appears, hence IN_ATTRIB.
+            if (e->len > 0) {
+                gamepad_try_open(e->name);
+            }
+            p += sizeof(struct inotify_event) + e->len;
+        }
+    }
+}
+
+static void* gamepad_thread_main(void* arg) {
+    (void)arg;
+    DIR* dir = opendir(LINUX_GAMEPAD_DEVICE_DIR);
+    if (dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != 0) {
+            gamepad_try_open(entry->d_name);
+        }
+        closedir(dir);
+    }
+
+    struct pollfd fds[2 + INPUT_MAX_GAMEPADS];
+    for (;;) {
+        u32 fd_count = 0;
+        fds[fd_count++] = (struct pollfd){state.wake_fd, POLLIN, 0};
+        fds[fd_count++] = (struct pollfd){state.inotify_fd, POLLIN, 0};
+        gamepad_device* polled[INPUT_MAX_GAMEPADS];
+        for (u32 i = 0; i < INPUT_MAX_GAMEPADS; ++i) {
+            if (state.devices[i].fd >= 0) {
+                polled[fd_count - 2] = &state.devices[i];
+                fds[fd_count++] = (struct pollfd){state.devices[i].fd, POLLIN, 0};
+            }
+        }
+
+        if (poll(fds, fd_count, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            verror("Gamepad thread: poll failed (%s); stopping.", strerror(errno));
+            break;
+        }
+        if (fds[0].revents) {
+            break;
+        }
+        for (u32 i = 2; i < fd_count; ++i) {
+            if (fds[i].revents) {
+                gamepad_read(polled[i - 2]);
+            }
+        }
+        if (fds[1].revents) {
+            gamepad_handle_inotify();
+        }
+    }
+    return 0;
+}
+
+b8 platform_linux_gamepad_startup() {
+    kzero_memory(&state, sizeof(state));
+    for (u32 i = 0; i < INPUT_MAX_GAMEPADS; ++i) {
+        state.devices[i].fd = -1;
+    }
+
+    state.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    state.inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (state.wake_fd < 0 || state.inotify_fd < 0) {
+        vwarn("Gamepad support disabled: unable to create notification descriptors.");
+        platform_linux_gamepad_shutdown();
+        return FALSE;
+    }
+    if (inotify_add_watch(state.inotify_fd, LINUX_GAMEPAD_DEVICE_DIR, IN_CREATE | IN_ATTRIB) < 0) {
+        vwarn("Unable to watch %s; gamepads connected later will not be seen.", LINUX_GAMEPAD_DEVICE_DIR);
+    }
+
+    if (pthread_create(&state.thread, 0, gamepad_thread_main, 0) != 0) {
+        vwarn("Gamepad support disabled: unable to start the gamepad thread.");
+        platform_linux_gamepad_shutdown();
+        return FALSE;
+    }
+    pthread_setname_np(state.thread, "gamepad");
+    state.running = TRUE;
+    return TRUE;
+}
+
+void platform_linux_gamepad_shutdown() {
+    if (state.running) {
+        u64 one = 1;
+        if (write(state.wake_fd, &one, sizeof(one)) == sizeof(one)) {
+            pthread_join(state.thread, 0);
+        }
+        state.running = FALSE;
+    }
+    for (u32 i = 0; i < INPUT_MAX_GAMEPADS; ++i) {
+        if (state.devices[i].fd >= 0) {
+            close(state.devices[i].fd);
+            state.devices[i].fd = -1;
+        }
+    }
+    if (state.wake_fd >= 0) {
+        close(state.wake_fd);
+    }
+    if (state.inotify_fd >= 0) {
+        close(state.inotify_fd);
+    }
+    state.wake_fd = -1;
+    state.inotify_fd = -1;
+}
+
+void platform_linux_gamepad_read(gamepad_state out_states[INPUT_MAX_GAMEPADS]) {
+    if (!state.running) {
+        kzero_memory(out_states, sizeof(gamepad_state) * INPUT_MAX_GAMEPADS);
+        return;
+    }
+    for (u32 i = 0; i < INPUT_MAX_GAMEPADS; ++i) {
+        gamepad_device* device = &state.devices[i];
+        gamepad_state* snapshot = &out_states[i];
+        for (;;) {
+            const gamepad_snapshot* front = &device->snapshots[atomic_load_explicit(&device->front, memory_order_acquire)];
+            u32 before = atomic_load_explicit(&front->sequence, memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            *snapshot = front->state;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&front->sequence, memory_order_relaxed) == before) {
+                break;
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "defines.h"
+#include "core/gamepad.h"
+
+/*
+Linux gamepad backend. A dedicated thread blocks on every evdev gamepad under
+/dev/input (and on inotify, for hot-plugging), so events are read as soon as the
+kernel delivers them rather than once per frame. After each complete report
+(SYN_REPORT) the thread publishes a normalized gamepad_state through a per-pad
+double buffer guarded by a sequence counter: the thread never waits, and the main
+thread retries its copy in the rare case it overlaps a publish.
+
+Buttons follow the kernel's positional gamepad layout (BTN_SOUTH is A, BTN_NORTH
+is Y, BTN_WEST is X). Devices are recognized by BTN_GAMEPAD, and are only opened
+if the user can read them.
+*/
+
+// Starts the gamepad thread. Returns FALSE if it could not be started.
+b8 platform_linux_gamepad_startup();
+
+// Stops the gamepad thread and closes every device.
+void platform_linux_gamepad_shutdown();
+
+// Copies the latest published state of every gamepad. Called from platform_pump_messages,
+// which hands the states to the input system.
+void platform_linux_gamepad_read(gamepad_state out_states[INPUT_MAX_GAMEPADS]);
@@ -24,10 +24,6 @@ typedef struct internal_state {
     VkSurfaceKHR surface;
 } internal_state;
 
-// Clock
-static f64 clock_frequency;
-static LARGE_INTEGER start_time;
-
 LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARAM l_param);
 
 b8 platform_startup(
@@ -112,12 +108,6 @@ b8 platform_startup(
     // If initially maximized, use SW_SHOWMAXIMIZED : SW_MAXIMIZE
     ShowWindow(state->hwnd, show_window_command_flags);
 
-    // Clock setup
-    LARGE_INTEGER frequency;
-    QueryPerformanceFrequency(&frequency);
-    clock_frequency = 1.0 / (f64)frequency.QuadPart;
-    QueryPerformanceCounter(&start_time);
-
     return TRUE;
 }
 
@@ -181,16 +171,56 @@ void platform_console_write_error(const char* str, u8 color) {
     WriteConsole(GetStdHandle(STD_ERROR_HANDLE), str, (DWORD) length, written, NULL);
 }
 
-f64 platform_get_absolute_time() {
+u64 platform_get_absolute_time_ns() {
+    // Queried on first use, as the clock is calibrated before platform_startup.
+    static u64 ticks_per_second = 0;
+    if (!ticks_per_second) {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        ticks_per_second = (u64)frequency.QuadPart;
+    }
     LARGE_INTEGER now_time;
     QueryPerformanceCounter(&now_time);
-    return (f64)now_time.QuadPart * clock_frequency;
+    u64 ticks = (u64)now_time.QuadPart;
+    // Whole seconds and the remainder separately, so the multiply cannot overflow.
+    return (ticks / ticks_per_second) * 1000000000ULL + (ticks % ticks_per_second) * 1000000000ULL / ticks_per_second;
 }
 
 void platform_sleep(u64 ms) {
     Sleep(ms);
 }
 
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+void platform_sleep_until_ns(u64 deadline_ns) {
+    // A high resolution timer (Windows 10 1803+) wakes within a fraction of a millisecond.
+    // Sleep() is left to the scheduler's tick, so it is only used as a fallback.
+    static HANDLE timer = 0;
+    static b8 timer_unavailable = FALSE;
+    if (!timer && !timer_unavailable) {
+        timer = CreateWaitableTimerExW(0, 0, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        timer_unavailable = timer == 0;
+    }
+
+    u64 now = platform_get_absolute_time_ns();
+    if (now >= deadline_ns) {
+        return;
+    }
+    u64 remaining = deadline_ns - now;
+    if (timer) {
+        LARGE_INTEGER due;
+        // Negative means relative, in 100ns units.
+        due.QuadPart = -(LONGLONG)(remaining / 100);
+        if (SetWaitableTimer(timer, &due, 0, 0, 0, FALSE)) {
+            WaitForSingleObject(timer, INFINITE);
+            return;
+        }
+    }
+    Sleep((DWORD)(remaining / 1000000));
+}
+
 void platform_get_required_extension_names(const char ***names_darray) {
     darray_push(*names_darray, &"VK_KHR_win32_surface");
 }
@@ -234,12 +264,13 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARA
             u32 width = r.right - r.left;
             u32 height = r.bottom - r.top;
 
-            // Fire the event. The application layer should pick this up, but not handle it
-            // as it shouldn be visible to other parts of the application.
-            event_context context;
+            // Post the event. The application layer should pick this up, but not handle it
+            // as it shouldn be visible to other parts of the application. Dragging the window
+            // produces many of these; the event system collapses them to one per frame.
+            event_context context = {};
             context.data.u16[0] = (u16)width;
             context.data.u16[1] = (u16)height;
-            event_fire(EVENT_CODE_RESIZED, 0, context);
+            event_post(EVENT_CODE_RESIZED, 0, context);
         } break;
         case WM_KEYDOWN:
         case WM_SYSKEYDOWN:
@@ -249,8 +280,8 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARA
             b8 pressed = (msg == WM_KEYDOWN || msg == WM_SYSKEYDOWN);
             keys key = (u16)w_param;
 
-            // Pass to the input subsystem for processing.
-            input_process_key(key, pressed);
+            // Pass to the input subsystem for processing, with the time the message was posted.
+            input_process_key(key, pressed, (u32)GetMessageTime());
         } break;
         case WM_MOUSEMOVE: {
             // Mouse move
@@ -293,7 +324,7 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARA
 
             // Pass over to the input subsystem.
             if (mouse_button != BUTTON_MAX_BUTTONS) {
-                input_process_button(mouse_button, pressed);
+                input_process_button(mouse_button, pressed, (u32)GetMessageTime());
             }
         } break;
     }
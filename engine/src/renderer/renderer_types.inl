@@ -11,6 +11,8 @@ typedef enum renderer_backend_type {
 typedef struct renderer_backend {
     struct platform_state* plat_state;
     u64 frame_number;
+    // The id of the application frame being drawn, for latency tracking.
+    u64 frame_id;
 
     b8 (*initialize)(struct renderer_backend* backend, const char* application_name, struct platform_state* plat_state);
 
@@ -24,4 +26,6 @@ typedef struct renderer_backend {
 
 typedef struct render_packet {
     f32 delta_time;
+    // The application frame this packet was built in; see event_frame_number.
+    u64 frame_id;
 } render_packet;
\ No newline at end of file
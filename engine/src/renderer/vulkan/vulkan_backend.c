@@ -13,6 +13,7 @@
 #include "core/logger.h"
 #include "core/str.h"
 #include "core/mem.h"
+#include "core/latency.h"
 #include "core/application.h"
 
 #include "containers/darray.h"
@@ -440,6 +441,7 @@ b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time)
     }
 
     vulkan_command_buffer_update_submitted(command_buffer);
+    latency_frame_submitted(backend->frame_id);
     // End queue submission
 
     // Give the image back to the swapchain.
@@ -449,7 +451,8 @@ b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time)
         context.device.graphics_queue,
         context.device.present_queue,
         context.queue_complete_semaphores[context.current_frame],
-        context.image_index);
+        context.image_index,
+        backend->frame_id);
 
 
     return TRUE;
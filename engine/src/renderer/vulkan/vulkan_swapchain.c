@@ -2,6 +2,7 @@
 
 #include "core/logger.h"
 #include "core/mem.h"
+#include "core/latency.h"
 #include "vulkan_device.h"
 #include "vulkan_image.h"
 
@@ -66,7 +67,8 @@ void vulkan_swapchain_present(
     VkQueue graphics_queue,
     VkQueue present_queue,
     VkSemaphore render_complete_semaphore,
-    u32 present_image_index) {
+    u32 present_image_index,
+    u64 frame_id) {
     // Return the image to the swapchain for presentation.
     VkPresentInfoKHR present_info = {VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
     present_info.waitSemaphoreCount = 1;
@@ -77,6 +79,10 @@ void vulkan_swapchain_present(
     present_info.pResults = 0;
 
     VkResult result = vkQueuePresentKHR(present_queue, &present_info);
+    if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
+        // The image was queued for display.
+        latency_frame_presented(frame_id);
+    }
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
         // Swapchain is out of date, suboptimal or a framebuffer resize has occurred. Trigger swapchain recreation.
         vulkan_swapchain_recreate(context, context->framebuffer_width, context->framebuffer_height, swapchain);
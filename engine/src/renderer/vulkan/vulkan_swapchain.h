@@ -32,4 +32,5 @@ void vulkan_swapchain_present(
     VkQueue graphics_queue,
     VkQueue present_queue,
     VkSemaphore render_complete_semaphore,
-    u32 present_image_index);
\ No newline at end of file
+    u32 present_image_index,
+    u64 frame_id);
\ No newline at end of file
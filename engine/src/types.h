@@ -13,11 +13,17 @@ typedef struct game {
     // Function pointer to game's initialize function.
     b8 (*initialize)(struct game* game_inst);
 
-    // Function pointer to game's update function.
+    // Function pointer to game's update function. Called once per frame.
     b8 (*update)(struct game* game_inst, f32 delta_time);
 
-    // Function pointer to game's render function.
-    b8 (*render)(struct game* game_inst, f32 delta_time);
+    // Function pointer to game's fixed-timestep update function. Required if
+    // app_config.fixed_update_rate is set, otherwise unused.
+    b8 (*fixed_update)(struct game* game_inst, f32 fixed_delta_time);
+
+    // Function pointer to game's render function. In fixed-timestep mode, alpha is how far
+    // the frame lies between the previous fixed update (0) and the next one (1), for
+    // interpolating simulated state; otherwise it is always 1.
+    b8 (*render)(struct game* game_inst, f32 delta_time, f32 alpha);
 
     // Function pointer to handle resizes, if applicable.
     void (*on_resize)(struct game* game_inst, u32 width, u32 height);